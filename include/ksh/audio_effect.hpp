@@ -0,0 +1,187 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "ksh/memory_usage.hpp"
+
+namespace ksh
+{
+
+    // Parameters of audio effects
+    // (lengths in measures: 0.125 = 1/8 measure; rates and mixes in [0, 1]; ranges "a-b" in .ksh use the second value)
+
+    struct RetriggerParams
+    {
+    public:
+        double waveLength = 0.125;
+        double updatePeriod = 0.5;
+        double rate = 0.7;
+        double mix = 1.0;
+    };
+
+    struct GateParams
+    {
+    public:
+        double waveLength = 0.125;
+        double rate = 0.6;
+        double mix = 0.9;
+    };
+
+    struct FlangerParams
+    {
+    public:
+        double periodMeasure = 2.0;
+        double delaySamples = 30.0;
+        double depthSamples = 45.0;
+        double feedback = 0.6;
+        double mix = 0.8;
+    };
+
+    struct PitchShiftParams
+    {
+    public:
+        double pitch = 12.0; // In semitones
+        double mix = 1.0;
+    };
+
+    struct BitCrusherParams
+    {
+    public:
+        double reductionSamples = 5.0;
+        double mix = 1.0;
+    };
+
+    struct PhaserParams
+    {
+    public:
+        double periodMeasure = 0.5;
+        double feedback = 0.35;
+        double stereoWidth = 0.0;
+        double mix = 0.5;
+    };
+
+    struct WobbleParams
+    {
+    public:
+        double waveLength = 1.0 / 12;
+        double loFreqHz = 500.0;
+        double hiFreqHz = 20000.0;
+        double q = 1.414;
+        double mix = 0.5;
+    };
+
+    struct TapeStopParams
+    {
+    public:
+        double speed = 0.5; // "TapeStop;17" in .ksh is 0.17
+        double mix = 1.0;
+    };
+
+    struct EchoParams
+    {
+    public:
+        double waveLength = 0.25;
+        double feedback = 0.6;
+        double mix = 1.0;
+    };
+
+    struct SideChainParams
+    {
+    public:
+        double periodMeasure = 0.25;
+        double holdTimeMeasure = 0.0625;
+        double attackTimeMs = 10.0;
+        double releaseTimeMeasure = 0.0625;
+        double ratio = 5.0;
+    };
+
+    struct FilterParams
+    {
+    public:
+        enum class Type : uint8_t
+        {
+            LowPass,
+            HighPass,
+            Peaking,
+        };
+
+        Type type = Type::Peaking;
+        double freqHz = 1000.0;
+        double q = 0.707;
+        double gainDb = 0.0; // Peaking only
+        double mix = 1.0;
+    };
+
+    // std::monostate = unknown effect (the FX note has no audio effect)
+    using AudioEffectParams = std::variant<
+        std::monostate,
+        RetriggerParams,
+        GateParams,
+        FlangerParams,
+        PitchShiftParams,
+        BitCrusherParams,
+        PhaserParams,
+        WobbleParams,
+        TapeStopParams,
+        EchoParams,
+        SideChainParams,
+        FilterParams>;
+
+    // Parse a built-in audio effect string in .ksh (e.g. "Retrigger;8", "Echo;4;60")
+    // paramStr is "fx-l_param1="/"fx-r_param1=", used only if audioEffectStr has no parameters
+    AudioEffectParams parseBuiltInAudioEffect(std::string_view audioEffectStr, std::string_view paramStr = "");
+
+    // Parse the parameters of a user-defined audio effect in .ksh (e.g. "type=Retrigger;waveLength=1/8;rate=60%")
+    AudioEffectParams parseAudioEffectDefinition(std::string_view definitionStr);
+
+    // Audio effects of a chart resolved at load time
+    // (the realtime path refers to them only by index)
+    class AudioEffectTable
+    {
+    public:
+        using Index = uint16_t;
+
+        static constexpr Index NONE = 0; // Index of std::monostate
+
+    private:
+        std::vector<AudioEffectParams> m_effects;
+        std::unordered_map<std::string, AudioEffectParams> m_definitions; // User-defined audio effects by name
+        std::unordered_map<std::string, Index> m_indices;                 // "audioEffectStr;paramStr" to index
+        bool m_overflowed = false;
+
+    public:
+        AudioEffectTable();
+
+        // Add a "#define_fx"/"#define_filter" line in .ksh (returns false if the line is not a definition)
+        bool addDefinitionLine(std::string_view line);
+
+        // Resolve an audio effect string of an FX note (user-defined names take priority over built-in effects)
+        // (NONE if the table already has as many effects as Index can hold)
+        Index resolve(const std::string & audioEffectStr, const std::string & paramStr);
+
+        // Whether resolve() has dropped an effect because the table was full
+        bool overflowed() const
+        {
+            return m_overflowed;
+        }
+
+        const AudioEffectParams & at(Index idx) const
+        {
+            return m_effects.at(idx);
+        }
+
+        std::size_t size() const
+        {
+            return m_effects.size();
+        }
+
+        MemoryUsage memoryUsage() const;
+    };
+
+}
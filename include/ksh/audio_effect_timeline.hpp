@@ -0,0 +1,78 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <cstddef>
+
+#include "ksh/lane.hpp"
+#include "ksh/audio_effect.hpp"
+#include "ksh/beat_map/beat_map.hpp"
+#include "ksh/chart_object/fx_note.hpp"
+
+namespace ksh
+{
+
+    // On/off intervals of audio effects of one FX lane (ms)
+    // Chip FX notes and FX notes without a known audio effect are not included
+    class AudioEffectTimeline
+    {
+    public:
+        struct Interval
+        {
+        public:
+            Ms startMs;
+            Ms endMs;
+            AudioEffectTable::Index effectIdx;
+        };
+
+        // Sequential sampler for monotonically increasing time (O(1) amortized; also works backward with a binary search)
+        class Cursor
+        {
+        private:
+            const AudioEffectTimeline * m_timeline;
+            std::size_t m_idx;
+
+        public:
+            explicit Cursor(const AudioEffectTimeline & timeline) : m_timeline(&timeline), m_idx(0) {}
+
+            // Index of the active audio effect (AudioEffectTable::NONE if off)
+            AudioEffectTable::Index effectIdxAt(Ms ms);
+        };
+
+    private:
+        std::vector<Interval> m_intervals; // Sorted by startMs (not overlapping)
+
+        // Index of the first interval that ends after ms
+        std::size_t intervalIdxAt(Ms ms) const;
+
+    public:
+        AudioEffectTimeline() = default;
+
+        // Audio effect strings of the notes are resolved with (and added to) table
+        AudioEffectTimeline(const Lane<FXNote> & lane, AudioEffectTable & table, const BeatMap & beatMap);
+
+        // Index of the active audio effect (AudioEffectTable::NONE if off)
+        AudioEffectTable::Index effectIdxAt(Ms ms) const;
+
+        Cursor cursor() const
+        {
+            return Cursor(*this);
+        }
+
+        const std::vector<Interval> & intervals() const
+        {
+            return m_intervals;
+        }
+
+        bool empty() const
+        {
+            return m_intervals.empty();
+        }
+
+        MemoryUsage memoryUsage() const
+        {
+            return vectorMemoryUsage(m_intervals);
+        }
+    };
+
+}
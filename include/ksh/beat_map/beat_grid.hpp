@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "ksh/beat_map/beat_map.hpp"
+#include "ksh/memory_usage.hpp"
+
+// Bar lines and beat lines baked into a sorted array (for drawing the grid without BeatMap lookups)
+class BeatGrid
+{
+public:
+    struct Line
+    {
+    public:
+        Measure y;
+        Ms ms;
+        int measureIdx;
+        int beatIdx; // 0 = bar line
+
+        bool isBarLine() const
+        {
+            return beatIdx == 0;
+        }
+    };
+
+    // Contiguous slice of the lines
+    class LineRange
+    {
+    private:
+        const Line * m_begin;
+        const Line * m_end;
+
+    public:
+        LineRange(const Line * begin, const Line * end) : m_begin(begin), m_end(end) {}
+
+        const Line * begin() const
+        {
+            return m_begin;
+        }
+
+        const Line * end() const
+        {
+            return m_end;
+        }
+
+        std::size_t size() const
+        {
+            return static_cast<std::size_t>(m_end - m_begin);
+        }
+
+        bool empty() const
+        {
+            return m_begin == m_end;
+        }
+    };
+
+private:
+    std::vector<Line> m_lines; // Sorted by y (and by ms)
+
+public:
+    BeatGrid() = default;
+
+    // Lines of measures [0, measureCount) and the bar line at the end of them
+    BeatGrid(const BeatMap & beatMap, int measureCount);
+
+    // Lines with y in [yBegin, yEnd)
+    LineRange linesInMeasureRange(Measure yBegin, Measure yEnd) const;
+
+    // Lines with ms in [msBegin, msEnd)
+    LineRange linesInMsRange(Ms msBegin, Ms msEnd) const;
+
+    const std::vector<Line> & lines() const
+    {
+        return m_lines;
+    }
+
+    bool empty() const
+    {
+        return m_lines.empty();
+    }
+
+    ksh::MemoryUsage memoryUsage() const
+    {
+        return ksh::vectorMemoryUsage(m_lines);
+    }
+};
@@ -1,27 +1,49 @@
 #pragma once
 
 #include <map>
+#include <vector>
+#include <memory_resource>
+#include <cstddef>
 #include <cstdint>
 
 #include "time_sig.hpp"
+#include "ksh/memory_usage.hpp"
 
 // Millisecond
 using Ms = double;
 
+// Microsecond (integer time domain for deterministic replays)
+using Us = int64_t;
+
+// Immutable after construction (const member functions can be called concurrently from multiple threads)
 class BeatMap
 {
 private:
-    const std::map<Measure, double> m_tempoChanges;
-    const std::map<int, TimeSig> m_timeSigChanges;
-    mutable std::map<Measure, Ms> m_tempoChangeMsCache;
-    mutable std::map<Ms, Measure> m_tempoChangeMeasureCache;
-    mutable std::map<int, Measure> m_timeSigChangeMeasureCache;
-    mutable std::map<Measure, int> m_timeSigChangeMeasureCountCache;
+    const std::pmr::map<Measure, double> m_tempoChanges;
+    const std::pmr::map<int, TimeSig> m_timeSigChanges;
+
+    // Filled in the constructor
+    std::pmr::map<Measure, Ms> m_tempoChangeMsCache;
+    std::pmr::map<Ms, Measure> m_tempoChangeMeasureCache;
+    std::pmr::map<int, Measure> m_timeSigChangeMeasureCache;
+    std::pmr::map<Measure, int> m_timeSigChangeMeasureCountCache;
+
+    // Tempo segments for the integer time domain (tempos are rounded to 1/1000 BPM)
+    struct TempoSegment
+    {
+        Measure y;
+        Us us;
+        int64_t milliTempo;
+    };
+    std::pmr::vector<TempoSegment> m_tempoSegments; // Sorted by y (and by us)
+
+    std::size_t tempoSegmentIdxAtMeasure(Measure measure) const;
 
 public:
     explicit BeatMap(double tempo) : BeatMap({ { 0, tempo } }) {}
     explicit BeatMap(const std::map<Measure, double> & tempoChanges = { { 0, 120.0 } },
-        const std::map<int, TimeSig> & timeSigChanges = { { 0, TimeSig{ 4, 4 } } });
+        const std::map<int, TimeSig> & timeSigChanges = { { 0, TimeSig{ 4, 4 } } },
+        std::pmr::memory_resource * resource = std::pmr::get_default_resource());
     Ms measureToMs(Measure measure) const;
     Measure msToMeasure(Ms ms) const;
     int measureToMeasureCount(Measure measure) const;
@@ -31,15 +53,35 @@ public:
     Ms measureCountToMs(int measureCount) const;
     Ms measureCountToMs(double measureCount) const;
     bool isBarLine(Measure measure) const;
+
+    // Integer counterparts of measureToMs()/msToMeasure()
+    // (exact integer arithmetic on each tempo segment; bit-identical on every platform)
+    // usToMeasure() returns the last measure position whose measureToUs() does not exceed us
+    Us measureToUs(Measure measure) const;
+    Measure usToMeasure(Us us) const;
+
+    // measureToUs() for many positions at once (linear when measures are sorted)
+    void measuresToUs(const Measure * measures, Us * dest, std::size_t count) const;
+
     double tempo(Measure measure) const;
     TimeSig timeSig(Measure measure) const;
+    ksh::MemoryUsage memoryUsage() const;
+
+    // Whether the tempo changes and the time signature changes are identical (the caches are derived from them)
+    bool isEquivalentTo(const BeatMap & other) const;
+
+    // Memory resource of the containers
+    std::pmr::memory_resource * memoryResource() const
+    {
+        return m_tempoChanges.get_allocator().resource();
+    }
 
-    const std::map<Measure, double> & tempoChanges() const
+    const std::pmr::map<Measure, double> & tempoChanges() const
     {
         return m_tempoChanges;
     }
 
-    const std::map<int, TimeSig> & timeSigChanges() const
+    const std::pmr::map<int, TimeSig> & timeSigChanges() const
     {
         return m_timeSigChanges;
     }
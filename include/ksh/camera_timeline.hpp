@@ -0,0 +1,120 @@
+#pragma once
+
+#include <map>
+#include <array>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <memory_resource>
+#include <cstddef>
+#include <cstdint>
+
+#include "ksh/beat_map/beat_map.hpp"
+#include "ksh/chart_object/line_graph.hpp"
+
+namespace ksh
+{
+
+    enum class TiltMode : uint8_t
+    {
+        Normal,
+        Bigger,
+        Biggest,
+        KeepNormal,
+        KeepBigger,
+        KeepBiggest,
+        Zero,
+        Manual, // Uses CameraState::manualTilt
+    };
+
+    // "tilt=" value in .ksh to TiltMode (unknown values are TiltMode::Normal)
+    TiltMode kshTiltStrToTiltMode(std::string_view str);
+
+    struct CameraState
+    {
+    public:
+        double zoomTop = 0.0;
+        double zoomBottom = 0.0;
+        double zoomSide = 0.0;
+        double centerSplit = 0.0;
+        double manualTilt = 0.0;
+        TiltMode tiltMode = TiltMode::Normal;
+    };
+
+    // Zoom, center split and tilt merged into one sorted time axis (structure of arrays)
+    // Each value is linear in ms between two adjacent breakpoints (tempo changes are also breakpoints)
+    class CameraTimeline
+    {
+    public:
+        enum Column : std::size_t
+        {
+            COLUMN_ZOOM_TOP,
+            COLUMN_ZOOM_BOTTOM,
+            COLUMN_ZOOM_SIDE,
+            COLUMN_CENTER_SPLIT,
+            COLUMN_MANUAL_TILT,
+            COLUMN_COUNT,
+        };
+
+        // Sequential sampler for monotonically increasing time (O(1) amortized; also works backward with a binary search)
+        class Cursor
+        {
+        private:
+            const CameraTimeline * m_timeline;
+            std::size_t m_idx;
+
+        public:
+            explicit Cursor(const CameraTimeline & timeline) : m_timeline(&timeline), m_idx(0) {}
+
+            CameraState stateAt(Ms ms);
+        };
+
+    private:
+        std::vector<Ms> m_breakpointMs;
+        std::array<std::vector<double>, COLUMN_COUNT> m_startValues; // Values just after each breakpoint
+        std::array<std::vector<double>, COLUMN_COUNT> m_endValues;   // Values just before the next breakpoint
+        std::vector<TiltMode> m_tiltModes;
+
+        std::size_t intervalIdxAt(Ms ms) const;
+
+        CameraState stateAt(std::size_t idx, Ms ms) const;
+
+    public:
+        CameraTimeline() = default;
+
+        CameraTimeline(
+            const std::array<const LineGraph *, COLUMN_COUNT> & graphs,
+            const std::pmr::map<Measure, std::pmr::string> & tiltOptions,
+            const BeatMap & beatMap);
+
+        CameraState stateAt(Ms ms) const;
+
+        Cursor cursor() const
+        {
+            return Cursor(*this);
+        }
+
+        const std::vector<Ms> & breakpointMs() const
+        {
+            return m_breakpointMs;
+        }
+
+        const std::vector<double> & startValues(Column column) const
+        {
+            return m_startValues.at(column);
+        }
+
+        const std::vector<double> & endValues(Column column) const
+        {
+            return m_endValues.at(column);
+        }
+
+        const std::vector<TiltMode> & tiltModes() const
+        {
+            return m_tiltModes;
+        }
+
+        MemoryUsage memoryUsage() const;
+    };
+
+}
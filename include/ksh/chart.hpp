@@ -1,10 +1,15 @@
 #pragma once
 
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 #include <fstream>
+#include <cstddef>
+
+#include "ksh/diagnostic.hpp"
 
 namespace ksh
 {
@@ -19,28 +24,47 @@ namespace ksh
         const std::string m_filename;
         const std::string m_fileDirectoryPath;
         std::unique_ptr<std::ifstream> m_ifs; // uses unique_ptr to make Chart objects move constructible
+        std::streampos m_bodyPos; // Position of the next line of the first bar line ("--")
+        std::size_t m_bodyLineNumber; // Line number of m_bodyPos
+        bool m_fileOpenFailed; // (the body is not parsed)
         int m_difficultyIdx;
-        Chart(std::string_view filename, bool keepFileStreamOpen);
+        mutable std::vector<Diagnostic> m_diagnostics; // (mutable because the body can be parsed on demand)
+        Chart(std::string_view filename, bool keepFileStreamOpen, std::pmr::memory_resource * resource);
+
+        void addDiagnostic(DiagnosticSeverity severity, std::size_t line, std::string message) const
+        {
+            m_diagnostics.push_back(Diagnostic{ severity, line, std::move(message) });
+        }
 
     public:
         // Chart meta data
-        std::unordered_map<std::string, std::string> metaData;
+        std::pmr::unordered_map<std::pmr::string, std::pmr::string> metaData;
 
-        explicit Chart(std::string_view filename);
+        explicit Chart(std::string_view filename, std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 
         virtual ~Chart() = default;
 
+        // Header in .ksh (known keys in the standard order, then the other keys sorted by name)
         std::string toString() const;
 
         bool isKshVersionNewerThanOrEqualTo(int version) const;
 
         int kshVersionInt() const;
 
+        // 0 if the difficulty is missing or unknown
         int difficultyIdx() const
         {
             return m_difficultyIdx;
         }
 
+        // Problems found while parsing (malformed lines are reported here instead of aborting)
+        // (virtual so that charts parsing the body on demand load it before the diagnostics are read through a Chart reference)
+        virtual const std::vector<Diagnostic> & diagnostics() const
+        {
+            return m_diagnostics;
+        }
+
+        // Whether the file is UTF-8 with BOM (Shift_JIS files are converted to UTF-8 while parsing, so strings are always UTF-8)
         bool isUTF8() const
         {
             return m_isUTF8;
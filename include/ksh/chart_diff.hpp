@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "ksh/playable_chart.hpp"
+
+namespace ksh
+{
+
+    enum class DiffKind : uint8_t
+    {
+        Added,
+        Removed,
+        Modified,
+    };
+
+    // Change of one element (before is nullptr if added, after is nullptr if removed)
+    // (pointers refer to the elements of the compared charts)
+    template <typename Key, typename T>
+    struct DiffEntry
+    {
+    public:
+        DiffKind kind;
+        Key key;
+        const T * before;
+        const T * after;
+    };
+
+    template <typename T>
+    using MeasureDiff = std::vector<DiffEntry<Measure, T>>; // Sorted by y
+
+    // Structural difference between two charts
+    // (the charts must outlive the diff; notes at the same y in a lane are paired in order)
+    template <class Layout>
+    struct BasicChartDiff
+    {
+    public:
+        std::vector<DiffEntry<std::string_view, std::pmr::string>> metaData; // Sorted by key
+
+        MeasureDiff<double> tempoChanges;
+        std::vector<DiffEntry<int, TimeSig>> timeSigChanges; // Keyed by measure index
+
+        std::array<MeasureDiff<BTNote>, Layout::BT_LANE_COUNT> btLanes;
+        std::array<MeasureDiff<FXNote>, Layout::FX_LANE_COUNT> fxLanes;
+        std::array<MeasureDiff<LaserNote>, Layout::LASER_LANE_COUNT> laserLanes;
+
+        MeasureDiff<LineGraph::Plot> zoomTop;
+        MeasureDiff<LineGraph::Plot> zoomBottom;
+        MeasureDiff<LineGraph::Plot> zoomSide;
+        MeasureDiff<LineGraph::Plot> centerSplit;
+        MeasureDiff<LineGraph::Plot> manualTilt;
+
+        std::vector<std::pair<std::string_view, MeasureDiff<std::pmr::string>>> positionalOptions; // Sorted by key (only changed keys)
+
+        // Total number of changes
+        std::size_t size() const;
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+    };
+
+    using ChartDiff = BasicChartDiff<DefaultLaneLayout>;
+
+    // Compare two charts with a linear merge over each sorted container (O(n + m))
+    // (notes are compared by their content in .ksh, i.e. not by the judgments derived from it)
+    template <class Layout>
+    BasicChartDiff<Layout> diffCharts(const BasicPlayableChart<Layout> & before, const BasicPlayableChart<Layout> & after);
+
+    extern template struct BasicChartDiff<DefaultLaneLayout>;
+    extern template struct BasicChartDiff<SixBTLaneLayout>;
+    extern template BasicChartDiff<DefaultLaneLayout> diffCharts(const BasicPlayableChart<DefaultLaneLayout> &, const BasicPlayableChart<DefaultLaneLayout> &);
+    extern template BasicChartDiff<SixBTLaneLayout> diffCharts(const BasicPlayableChart<SixBTLaneLayout> &, const BasicPlayableChart<SixBTLaneLayout> &);
+
+}
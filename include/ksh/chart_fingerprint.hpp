@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "ksh/playable_chart.hpp"
+
+namespace ksh
+{
+
+    // 128-bit identity of the gameplay content of a chart
+    // (comments, line endings, BOM and meta data such as "jacket" do not affect it)
+    struct ChartFingerprint
+    {
+    public:
+        uint64_t low;
+        uint64_t high;
+
+        std::string toString() const; // 32 lowercase hex digits
+
+        bool operator==(const ChartFingerprint & rhs) const
+        {
+            return low == rhs.low && high == rhs.high;
+        }
+
+        bool operator!=(const ChartFingerprint & rhs) const
+        {
+            return !(*this == rhs);
+        }
+
+        bool operator<(const ChartFingerprint & rhs) const
+        {
+            return (high != rhs.high) ? (high < rhs.high) : (low < rhs.low);
+        }
+    };
+
+    // Hash the notes, the beat map, the line graphs and the positional options of the chart (MurmurHash3 x64 128)
+    ChartFingerprint computeFingerprint(const PlayableChart & chart);
+
+}
+
+namespace std
+{
+
+    template <>
+    struct hash<ksh::ChartFingerprint>
+    {
+        std::size_t operator()(const ksh::ChartFingerprint & fingerprint) const
+        {
+            return static_cast<std::size_t>(fingerprint.low ^ (fingerprint.high * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include "ksh/playable_chart.hpp"
+
+namespace ksh
+{
+
+    // KSON-like JSON export of a chart (y values are in Measure units; UNIT_MEASURE = 1 measure of 4/4)
+    //
+    // {
+    //   "format_version": 1,
+    //   "meta": { "<key>": "<value>", ... },                       (header; sorted by key)
+    //   "beat": { "bpm": [[y, tempo], ...], "time_sig": [[measureIdx, [numerator, denominator]], ...] },
+    //   "note": {
+    //     "bt": [[[y, length], ...], ...],
+    //     "fx": [[[y, length(, "audioEffect"(, "audioEffectParam"))], ...], ...],
+    //     "laser": [[[y, length, startX, endX(, "laneSpin")], ...], ...]
+    //   },
+    //   "camera": { "zoom_top": [[y, value(, valueFinal)], ...], "zoom_bottom", "zoom_side", "center_split", "manual_tilt" },
+    //   "options": { "<key>": [[y, "<value>"], ...], ... }          (positional options; sorted by key)
+    // }
+    //
+    // Values are written directly to a fixed-size buffer (no intermediate DOM, no allocation per value)
+
+    // Write to os (flushed every 64 KiB)
+    void writeChartJSON(std::ostream & os, const PlayableChart & chart);
+
+    // Append to str
+    void appendChartJSON(std::string & str, const PlayableChart & chart);
+
+    std::string chartToJSON(const PlayableChart & chart);
+
+}
@@ -7,5 +7,8 @@ struct AbstractMusicalSegment
 public:
     Measure length;
     explicit AbstractMusicalSegment(Measure length = 0) : length(length) {}
-    virtual ~AbstractMusicalSegment() = default;
+
+protected:
+    // Non-virtual (segments are stored by value, so they do not need a vptr)
+    ~AbstractMusicalSegment() = default;
 };
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <map>
+#include <memory_resource>
+#include <utility>
 #include <cstddef>
 
 #include "ksh/beat_map/beat_map.hpp"
@@ -9,8 +11,14 @@
 
 struct AbstractNote : public AbstractMusicalSegment
 {
+public:
+    using Judgments = std::pmr::map<Measure, NoteJudgment>;
+
+    // Allocator-aware (uses-allocator construction in std::pmr containers places the judgments in their memory resource)
+    using allocator_type = Judgments::allocator_type;
+
 protected:
-    std::map<Measure, NoteJudgment> m_judgments;
+    Judgments m_judgments;
 
 public:
     explicit AbstractNote(Measure length = 0)
@@ -18,13 +26,16 @@ public:
     {
     }
 
-    virtual ~AbstractNote() = default;
-
     std::size_t comboCount() const
     {
         return m_judgments.size();
     }
 
+    const Judgments & judgments() const
+    {
+        return m_judgments;
+    }
+
     static constexpr Measure judgmentInterval(bool halvesCombo)
     {
         return UNIT_MEASURE / (halvesCombo ? 8 : 16);
@@ -34,4 +45,25 @@ public:
     {
         return UNIT_MEASURE * 3 / (halvesCombo ? 8 : 16);
     }
+
+protected:
+    // Declared explicitly so that the judgment map is moved rather than copied
+    AbstractNote(const AbstractNote &) = default;
+    AbstractNote(AbstractNote &&) = default;
+    AbstractNote & operator=(const AbstractNote &) = default;
+    AbstractNote & operator=(AbstractNote &&) = default;
+
+    AbstractNote(const AbstractNote & other, const allocator_type & alloc)
+        : AbstractMusicalSegment(other)
+        , m_judgments(other.m_judgments, alloc)
+    {
+    }
+
+    AbstractNote(AbstractNote && other, const allocator_type & alloc)
+        : AbstractMusicalSegment(other)
+        , m_judgments(std::move(other.m_judgments), alloc)
+    {
+    }
+
+    ~AbstractNote() = default;
 };
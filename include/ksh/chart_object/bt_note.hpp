@@ -30,4 +30,8 @@ public:
             }
         }
     }
+
+    BTNote(const BTNote & other, const allocator_type & alloc) : AbstractNote(other, alloc) {}
+
+    BTNote(BTNote && other, const allocator_type & alloc) : AbstractNote(std::move(other), alloc) {}
 };
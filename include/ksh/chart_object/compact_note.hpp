@@ -0,0 +1,38 @@
+#pragma once
+
+#include <type_traits>
+#include <cstdint>
+
+#include "ksh/beat_map/time_sig.hpp"
+
+// Player-facing note without judgment maps or editor-only payloads (24 bytes, trivially copyable)
+struct CompactNote
+{
+public:
+    static constexpr uint32_t NO_SIDECAR = UINT32_MAX;
+
+    Measure y;
+    Measure length;
+
+    // Index of the editor-only payload in the sidecar table (FX: audio effect, laser: lane spin)
+    uint32_t sidecarIdx;
+
+    uint16_t comboCount;
+
+    // Laser only (0-LaserNote::X_MAX)
+    int8_t startX;
+    int8_t endX;
+
+    bool hasSidecar() const
+    {
+        return sidecarIdx != NO_SIDECAR;
+    }
+
+    bool isSlam() const
+    {
+        return length <= UNIT_MEASURE / 32;
+    }
+};
+
+static_assert(std::is_trivially_copyable<CompactNote>::value, "CompactNote must be trivially copyable");
+static_assert(sizeof(CompactNote) <= 24, "CompactNote must fit in 24 bytes");
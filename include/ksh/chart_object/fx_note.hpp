@@ -7,7 +7,7 @@
 struct FXNote final : public AbstractNote
 {
 public:
-    // Only used in editor
+    // Resolved into PlayableChart::audioEffectTimelines() at load time
     std::string audioEffectStr;
     std::string audioEffectParamStr;
 
@@ -39,4 +39,18 @@ public:
             }
         }
     }
+
+    FXNote(const FXNote & other, const allocator_type & alloc)
+        : AbstractNote(other, alloc)
+        , audioEffectStr(other.audioEffectStr)
+        , audioEffectParamStr(other.audioEffectParamStr)
+    {
+    }
+
+    FXNote(FXNote && other, const allocator_type & alloc)
+        : AbstractNote(std::move(other), alloc)
+        , audioEffectStr(std::move(other.audioEffectStr))
+        , audioEffectParamStr(std::move(other.audioEffectParamStr))
+    {
+    }
 };
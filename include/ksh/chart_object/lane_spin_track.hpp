@@ -0,0 +1,87 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <cstddef>
+
+#include "ksh/beat_map/beat_map.hpp"
+#include "ksh/chart_object/lane_spin.hpp"
+
+// Lane transform caused by lane spins
+struct LaneTransform
+{
+public:
+    double rotation = 0.0; // In turns (1.0 = 360 degrees; positive = right)
+    double swing = 0.0;    // In the unit of LaneSpin::swingAmplitude (positive = right)
+};
+
+// Lane spins baked into a time-ordered track (ms)
+//
+// With t = (ms - startMs) / (endMs - startMs) in [0, 1):
+//   Normal: rotation = sign * (1 - (1 - t)^2)
+//   Half:   rotation = sign * 0.5 * sin(pi * t)
+//   Swing:  swing    = sign * amplitude * sin(2 * pi * frequency * t) * (1 - t)^decayOrder
+// A spin that starts while another spin is active replaces it.
+class LaneSpinTrack
+{
+public:
+    struct Keyframe
+    {
+    public:
+        Ms startMs;
+        Ms endMs;
+        LaneSpin::Type type;
+        double sign; // -1.0 (left) or 1.0 (right)
+        double swingAmplitude;
+        double swingFrequency;
+        int swingDecayOrder;
+
+        LaneTransform transformAt(Ms ms) const;
+    };
+
+    // Sequential sampler for monotonically increasing time (O(1) amortized; also works backward with a binary search)
+    class Cursor
+    {
+    private:
+        const LaneSpinTrack * m_track;
+        std::size_t m_nextIdx; // Index of the first keyframe that starts after the last time
+
+    public:
+        explicit Cursor(const LaneSpinTrack & track) : m_track(&track), m_nextIdx(0) {}
+
+        LaneTransform transformAt(Ms ms);
+    };
+
+private:
+    std::vector<Keyframe> m_keyframes; // Sorted by startMs
+
+    LaneTransform transformAt(std::size_t nextIdx, Ms ms) const;
+
+public:
+    LaneSpinTrack() = default;
+
+    // Invalid lane spins are ignored
+    LaneSpinTrack(const std::map<Measure, LaneSpin> & laneSpins, const BeatMap & beatMap);
+
+    LaneTransform transformAt(Ms ms) const;
+
+    Cursor cursor() const
+    {
+        return Cursor(*this);
+    }
+
+    const std::vector<Keyframe> & keyframes() const
+    {
+        return m_keyframes;
+    }
+
+    bool empty() const
+    {
+        return m_keyframes.empty();
+    }
+
+    ksh::MemoryUsage memoryUsage() const
+    {
+        return ksh::vectorMemoryUsage(m_keyframes);
+    }
+};
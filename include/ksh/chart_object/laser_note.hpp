@@ -12,6 +12,22 @@ public:
 
     LaserNote(Measure length, int startX, int endX, Measure judgmentAlignmentOffsetY = 0, bool halvesCombo = false, const LaneSpin & laneSpin = LaneSpin());
 
+    LaserNote(const LaserNote & other, const allocator_type & alloc)
+        : AbstractNote(other, alloc)
+        , startX(other.startX)
+        , endX(other.endX)
+        , laneSpin(other.laneSpin)
+    {
+    }
+
+    LaserNote(LaserNote && other, const allocator_type & alloc)
+        : AbstractNote(std::move(other), alloc)
+        , startX(other.startX)
+        , endX(other.endX)
+        , laneSpin(other.laneSpin)
+    {
+    }
+
     bool isSlam() const
     {
         return length <= UNIT_MEASURE / 32;
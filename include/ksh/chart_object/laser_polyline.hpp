@@ -0,0 +1,78 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <cstddef>
+
+#include "ksh/lane.hpp"
+#include "ksh/beat_map/beat_map.hpp"
+#include "ksh/chart_object/laser_note.hpp"
+#include "ksh/positional_option_tracks.hpp"
+
+// Laser lane as a flat list of (ms, x) points
+class LaserPolyline
+{
+public:
+    struct Point
+    {
+    public:
+        Ms ms;
+        double x; // 0.0 (left) - 1.0 (right) (-0.5 - 1.5 in wide lasers)
+        bool connectedToNext; // false at the end of a laser (no laser until the next point)
+    };
+
+    // Sequential sampler for monotonically increasing time (O(1) amortized; also works backward with a binary search)
+    class Cursor
+    {
+    private:
+        const LaserPolyline * m_polyline;
+        std::size_t m_idx;
+
+    public:
+        explicit Cursor(const LaserPolyline & polyline) : m_polyline(&polyline), m_idx(0) {}
+
+        // X at the given time (NaN if there is no laser)
+        double xAt(Ms ms);
+    };
+
+private:
+    std::vector<Point> m_points;
+
+    // Index of the last point whose time is less than or equal to ms (SIZE_MAX if none)
+    std::size_t lastPointIdxAt(Ms ms) const;
+
+    double interpolate(std::size_t idx, Ms ms) const;
+
+public:
+    LaserPolyline() = default;
+
+    // Slams become two points at the same time, and points are inserted at tempo changes inside a laser
+    // laserRanges: "laserrange_l=" or "laserrange_r=" track (a "2x" point at the start of a laser section makes the section wide)
+    LaserPolyline(const ksh::Lane<LaserNote> & lane, const BeatMap & beatMap, const ksh::PositionalOptionTracks::Track & laserRanges = {});
+
+    // X at the given time (NaN if there is no laser; the value after the slam at the slam time)
+    double xAt(Ms ms) const;
+
+    // X at each time in msArray (must be sorted in ascending order; one linear pass)
+    void sample(const Ms * msArray, std::size_t count, double * xArray) const;
+
+    Cursor cursor() const
+    {
+        return Cursor(*this);
+    }
+
+    const std::vector<Point> & points() const
+    {
+        return m_points;
+    }
+
+    bool empty() const
+    {
+        return m_points.empty();
+    }
+
+    ksh::MemoryUsage memoryUsage() const
+    {
+        return ksh::vectorMemoryUsage(m_points);
+    }
+};
@@ -1,20 +1,25 @@
 #pragma once
 
 #include <map>
+#include <memory_resource>
 #include <string>
 #include <cstddef>
 
 #include "ksh/beat_map/time_sig.hpp"
+#include "ksh/memory_usage.hpp"
 
 class LineGraph
 {
 public:
     using Plot = std::pair<double, double>;
+    using Plots = std::pmr::map<Measure, Plot>;
 
 private:
-    std::map<Measure, Plot> m_plots;
+    Plots m_plots;
 
 public:
+    explicit LineGraph(std::pmr::memory_resource * resource = std::pmr::get_default_resource()) : m_plots(resource) {}
+
     void insert(Measure measure, double plot);
     void insert(Measure measure, Plot plot);
     void insert(Measure measure, const std::string & plot);
@@ -26,32 +31,32 @@ public:
         return m_plots.at(measure);
     }
 
-    std::map<Measure, Plot>::iterator begin()
+    Plots::iterator begin()
     {
         return m_plots.begin();
     }
 
-    std::map<Measure, Plot>::const_iterator begin() const
+    Plots::const_iterator begin() const
     {
         return m_plots.begin();
     }
 
-    std::map<Measure, Plot>::const_iterator cbegin() const
+    Plots::const_iterator cbegin() const
     {
         return m_plots.cbegin();
     }
 
-    std::map<Measure, Plot>::iterator end()
+    Plots::iterator end()
     {
         return m_plots.end();
     }
 
-    std::map<Measure, Plot>::const_iterator end() const
+    Plots::const_iterator end() const
     {
         return m_plots.end();
     }
 
-    std::map<Measure, Plot>::const_iterator cend() const
+    Plots::const_iterator cend() const
     {
         return m_plots.cend();
     }
@@ -69,4 +74,9 @@ public:
     double valueAt(Measure measure) const;
 
     std::string stringValueAt(Measure measure) const;
+
+    ksh::MemoryUsage memoryUsage() const
+    {
+        return ksh::treeMemoryUsage(m_plots);
+    }
 };
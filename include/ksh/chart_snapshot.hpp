@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+#include "ksh/playable_chart.hpp"
+
+namespace ksh
+{
+
+    // Lanes are split into chunks of this length (by the y of each note) in snapshots
+    constexpr Measure SNAPSHOT_CHUNK_LENGTH = UNIT_MEASURE * 4;
+
+    inline std::size_t snapshotChunkIdx(Measure y)
+    {
+        return static_cast<std::size_t>(y / SNAPSHOT_CHUNK_LENGTH);
+    }
+
+    // Immutable lane split into shared chunks (snapshots share unchanged chunks)
+    template <class Note>
+    class LaneSnapshot
+    {
+    public:
+        using Chunk = Lane<Note>;
+
+    private:
+        std::vector<std::shared_ptr<const Chunk>> m_chunks; // nullptr = no notes
+
+    public:
+        LaneSnapshot() = default;
+
+        explicit LaneSnapshot(std::vector<std::shared_ptr<const Chunk>> && chunks) : m_chunks(std::move(chunks)) {}
+
+        const std::shared_ptr<const Chunk> & chunk(std::size_t idx) const
+        {
+            static const std::shared_ptr<const Chunk> s_emptyChunk;
+            return (idx < m_chunks.size()) ? m_chunks[idx] : s_emptyChunk;
+        }
+
+        std::size_t chunkCount() const
+        {
+            return m_chunks.size();
+        }
+    };
+
+    // Chunks of a lane modified since the last snapshot/restore
+    class DirtyChunks
+    {
+    private:
+        bool m_all = true;
+        std::vector<bool> m_flags;
+
+    public:
+        // Mark the notes whose y is in [yBegin, yEnd)
+        void mark(Measure yBegin, Measure yEnd)
+        {
+            if (m_all || yEnd <= yBegin)
+            {
+                return;
+            }
+            const std::size_t lastIdx = snapshotChunkIdx(yEnd - 1);
+            if (m_flags.size() <= lastIdx)
+            {
+                m_flags.resize(lastIdx + 1, false);
+            }
+            for (std::size_t idx = snapshotChunkIdx(yBegin); idx <= lastIdx; ++idx)
+            {
+                m_flags[idx] = true;
+            }
+        }
+
+        void markAll()
+        {
+            m_all = true;
+            m_flags.clear();
+        }
+
+        void clear()
+        {
+            m_all = false;
+            m_flags.clear();
+        }
+
+        bool all() const
+        {
+            return m_all;
+        }
+
+        bool any() const
+        {
+            return m_all || std::find(m_flags.begin(), m_flags.end(), true) != m_flags.end();
+        }
+
+        bool isDirty(std::size_t idx) const
+        {
+            return m_all || (idx < m_flags.size() && m_flags[idx]);
+        }
+    };
+
+    // Snapshot of a lane (chunks that are not dirty are shared with base)
+    template <class Note>
+    LaneSnapshot<Note> takeLaneSnapshot(const Lane<Note> & lane, const LaneSnapshot<Note> & base, const DirtyChunks & dirtyChunks)
+    {
+        const std::size_t chunkCount = lane.empty() ? 0 : snapshotChunkIdx(lane.rbegin()->first) + 1;
+        std::vector<std::shared_ptr<const Lane<Note>>> chunks;
+        chunks.reserve(chunkCount);
+        for (std::size_t idx = 0; idx < chunkCount; ++idx)
+        {
+            if (!dirtyChunks.isDirty(idx))
+            {
+                chunks.push_back(base.chunk(idx));
+                continue;
+            }
+
+            const auto first = lane.lower_bound(static_cast<Measure>(idx) * SNAPSHOT_CHUNK_LENGTH);
+            const auto last = lane.lower_bound(static_cast<Measure>(idx + 1) * SNAPSHOT_CHUNK_LENGTH);
+            chunks.push_back((first == last) ? nullptr : std::make_shared<const Lane<Note>>(first, last));
+        }
+        return LaneSnapshot<Note>(std::move(chunks));
+    }
+
+    // Whether the chunks of a lane that are not dirty still match base (compares the y and length of each note; for debug checks)
+    template <class Note>
+    bool cleanChunksMatch(const Lane<Note> & lane, const LaneSnapshot<Note> & base, const DirtyChunks & dirtyChunks)
+    {
+        if (dirtyChunks.all())
+        {
+            return true;
+        }
+
+        const std::size_t laneChunkCount = lane.empty() ? 0 : snapshotChunkIdx(lane.rbegin()->first) + 1;
+        const std::size_t chunkCount = std::max(laneChunkCount, base.chunkCount());
+        for (std::size_t idx = 0; idx < chunkCount; ++idx)
+        {
+            if (dirtyChunks.isDirty(idx))
+            {
+                continue;
+            }
+
+            auto itr = lane.lower_bound(static_cast<Measure>(idx) * SNAPSHOT_CHUNK_LENGTH);
+            const auto last = lane.lower_bound(static_cast<Measure>(idx + 1) * SNAPSHOT_CHUNK_LENGTH);
+            if (const auto & baseChunk = base.chunk(idx))
+            {
+                for (const auto & [ y, note ] : *baseChunk)
+                {
+                    if (itr == last || itr->first != y || itr->second.length != note.length)
+                    {
+                        return false;
+                    }
+                    ++itr;
+                }
+            }
+            if (itr != last)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Restore a lane whose content is base (except dirty chunks) to target (only changed chunks are copied)
+    // Returns false if the lane was already equal to target
+    template <class Note>
+    bool restoreLaneSnapshot(Lane<Note> & lane, const LaneSnapshot<Note> & base, const LaneSnapshot<Note> & target, const DirtyChunks & dirtyChunks)
+    {
+        bool changed = false;
+        if (dirtyChunks.all())
+        {
+            lane.clear();
+            changed = true;
+        }
+
+        const std::size_t laneChunkCount = lane.empty() ? 0 : snapshotChunkIdx(lane.rbegin()->first) + 1;
+        const std::size_t chunkCount = std::max({ laneChunkCount, base.chunkCount(), target.chunkCount() });
+        for (std::size_t idx = 0; idx < chunkCount; ++idx)
+        {
+            const auto & targetChunk = target.chunk(idx);
+            if (!dirtyChunks.all() && !dirtyChunks.isDirty(idx) && base.chunk(idx) == targetChunk)
+            {
+                continue;
+            }
+
+            changed = true;
+            const Measure chunkEnd = static_cast<Measure>(idx + 1) * SNAPSHOT_CHUNK_LENGTH;
+            lane.erase(lane.lower_bound(static_cast<Measure>(idx) * SNAPSHOT_CHUNK_LENGTH), lane.lower_bound(chunkEnd));
+            if (targetChunk != nullptr)
+            {
+                const auto hint = lane.lower_bound(chunkEnd);
+                for (const auto & pair : *targetChunk)
+                {
+                    lane.insert(hint, pair);
+                }
+            }
+        }
+        return changed;
+    }
+
+    // Snapshot of all lanes of a chart (cheap to copy; unchanged chunks are shared between snapshots)
+    template <class Layout>
+    struct BasicChartSnapshot
+    {
+    public:
+        std::array<LaneSnapshot<BTNote>, Layout::BT_LANE_COUNT> btLanes;
+        std::array<LaneSnapshot<FXNote>, Layout::FX_LANE_COUNT> fxLanes;
+        std::array<LaneSnapshot<LaserNote>, Layout::LASER_LANE_COUNT> laserLanes;
+    };
+
+    using ChartSnapshot = BasicChartSnapshot<DefaultLaneLayout>;
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "ksh/diagnostic.hpp"
+
+namespace ksh
+{
+
+    // Diagnostics of one chart file
+    struct ChartValidationReport
+    {
+    public:
+        std::string filename;
+        uint64_t fileSize = 0;
+        std::vector<Diagnostic> diagnostics; // Sorted by line
+
+        std::size_t count(DiagnosticSeverity severity) const;
+
+        bool hasError() const
+        {
+            return count(DiagnosticSeverity::Error) > 0;
+        }
+    };
+
+    struct CorpusValidationResult
+    {
+    public:
+        std::vector<ChartValidationReport> reports; // Same order as the given filenames
+        std::size_t errorFileCount = 0;
+        uint64_t totalBytes = 0;
+        double elapsedSec = 0.0;
+
+        double filesPerSec() const
+        {
+            return (elapsedSec > 0.0) ? reports.size() / elapsedSec : 0.0;
+        }
+
+        double megabytesPerSec() const
+        {
+            return (elapsedSec > 0.0) ? totalBytes / elapsedSec / (1024 * 1024) : 0.0;
+        }
+    };
+
+    // Parse a chart file and collect its diagnostics (never aborts; exceptions are reported as errors)
+    ChartValidationReport validateChart(const std::string & chartFilename, std::pmr::memory_resource * resource = std::pmr::get_default_resource());
+
+    // Validate chart files on threadCount threads (0 = all cores)
+    CorpusValidationResult validateCorpus(const std::vector<std::string> & chartFilenames, std::size_t threadCount = 0);
+
+}
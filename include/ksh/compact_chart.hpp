@@ -0,0 +1,107 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstddef>
+
+#include "ksh/playable_chart.hpp"
+#include "ksh/chart_object/compact_note.hpp"
+#include "ksh/chart_object/lane_spin.hpp"
+
+namespace ksh
+{
+
+    using CompactLane = std::vector<CompactNote>; // Sorted by y
+
+    // Editor-only payload of FX notes
+    struct FXAudioEffectPayload
+    {
+    public:
+        std::string audioEffectStr;
+        std::string audioEffectParamStr;
+    };
+
+    // Dense copy of the notes of a chart for gameplay
+    // (editor-only payloads are moved to sidecar tables indexed by CompactNote::sidecarIdx)
+    template <class Layout>
+    class BasicCompactChart
+    {
+    public:
+        using BTLanes = std::array<CompactLane, Layout::BT_LANE_COUNT>;
+        using FXLanes = std::array<CompactLane, Layout::FX_LANE_COUNT>;
+        using LaserLanes = std::array<CompactLane, Layout::LASER_LANE_COUNT>;
+
+    private:
+        BTLanes m_btLanes;
+        FXLanes m_fxLanes;
+        LaserLanes m_laserLanes;
+
+        // Sidecar tables
+        std::vector<FXAudioEffectPayload> m_fxAudioEffects; // Deduplicated
+        std::vector<LaneSpin> m_laneSpins;
+
+    public:
+        explicit BasicCompactChart(const BasicPlayableChart<Layout> & chart);
+
+        const CompactLane & btLane(std::size_t idx) const
+        {
+            return m_btLanes.at(idx);
+        }
+
+        const CompactLane & fxLane(std::size_t idx) const
+        {
+            return m_fxLanes.at(idx);
+        }
+
+        const CompactLane & laserLane(std::size_t idx) const
+        {
+            return m_laserLanes.at(idx);
+        }
+
+        const BTLanes & btLanes() const
+        {
+            return m_btLanes;
+        }
+
+        const FXLanes & fxLanes() const
+        {
+            return m_fxLanes;
+        }
+
+        const LaserLanes & laserLanes() const
+        {
+            return m_laserLanes;
+        }
+
+        // Audio effect of an FX note (nullptr if the note has no audio effect)
+        const FXAudioEffectPayload * fxAudioEffect(const CompactNote & fxNote) const
+        {
+            return fxNote.hasSidecar() ? &m_fxAudioEffects.at(fxNote.sidecarIdx) : nullptr;
+        }
+
+        // Lane spin of a laser slam (nullptr if the note has no lane spin)
+        const LaneSpin * laneSpin(const CompactNote & laserNote) const
+        {
+            return laserNote.hasSidecar() ? &m_laneSpins.at(laserNote.sidecarIdx) : nullptr;
+        }
+
+        const std::vector<FXAudioEffectPayload> & fxAudioEffects() const
+        {
+            return m_fxAudioEffects;
+        }
+
+        const std::vector<LaneSpin> & laneSpins() const
+        {
+            return m_laneSpins;
+        }
+
+        std::size_t comboCount() const;
+    };
+
+    using CompactChart = BasicCompactChart<DefaultLaneLayout>;
+
+    extern template class BasicCompactChart<DefaultLaneLayout>;
+    extern template class BasicCompactChart<SixBTLaneLayout>;
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace ksh
+{
+
+    enum class DiagnosticSeverity : uint8_t
+    {
+        Warning, // The chart is loaded, but the line is ignored or interpreted with a fallback value
+        Error,   // The chart is broken (e.g. no bar line, no tempo at the beginning)
+    };
+
+    // Problem found while parsing a chart file
+    struct Diagnostic
+    {
+    public:
+        DiagnosticSeverity severity;
+        std::size_t line; // 1-based line number in the file (0 = not associated with a line)
+        std::string message;
+    };
+
+    // Whether the chart is broken
+    inline bool hasError(const std::vector<Diagnostic> & diagnostics)
+    {
+        return std::any_of(diagnostics.begin(), diagnostics.end(), [](const Diagnostic & diagnostic) { return diagnostic.severity == DiagnosticSeverity::Error; });
+    }
+
+}
@@ -1,52 +1,335 @@
 #pragma once
 
+#include <stdexcept>
+#include <cassert>
+
 #include "ksh/playable_chart.hpp"
+#include "ksh/chart_snapshot.hpp"
 
 namespace ksh
 {
 
+    // Editor of the notes of one lane whose y is in [yBegin, yEnd) (returned by BasicEditableChart::editXXXLane())
+    //
+    // add()/erase() throw std::out_of_range outside the range and mark the chunk of y as modified on each call,
+    // so an editor kept across snapshot()/restore() is still tracked. Do not keep it after the chart is destroyed.
+    template <class Note>
+    class LaneEditor
+    {
+    private:
+        Lane<Note> & m_lane;
+        DirtyChunks & m_dirtyChunks;
+        bool * const m_derivedDirty; // nullptr if the lane has no derived structures
+        const Measure m_yBegin;
+        const Measure m_yEnd;
+
+        void checkRange(Measure y) const
+        {
+            if (y < m_yBegin || y >= m_yEnd)
+            {
+                throw std::out_of_range("LaneEditor: y is outside the edit range");
+            }
+        }
+
+        void markDirty(Measure y)
+        {
+            m_dirtyChunks.mark(y, y + 1);
+            if (m_derivedDirty != nullptr)
+            {
+                *m_derivedDirty = true;
+            }
+        }
+
+    public:
+        LaneEditor(Lane<Note> & lane, DirtyChunks & dirtyChunks, bool * derivedDirty, Measure yBegin, Measure yEnd)
+            : m_lane(lane)
+            , m_dirtyChunks(dirtyChunks)
+            , m_derivedDirty(derivedDirty)
+            , m_yBegin(yBegin)
+            , m_yEnd(yEnd)
+        {
+        }
+
+        LaneEditor(const LaneEditor &) = delete;
+
+        LaneEditor & operator=(const LaneEditor &) = delete;
+
+        // Add a note at y
+        void add(Measure y, const Note & note)
+        {
+            checkRange(y);
+            markDirty(y);
+            m_lane.emplace(y, note);
+        }
+
+        // Remove the notes at y (returns false if there is none)
+        bool erase(Measure y)
+        {
+            checkRange(y);
+            if (m_lane.erase(y) == 0)
+            {
+                return false;
+            }
+            markDirty(y);
+            return true;
+        }
+
+        // Whole lane (read only)
+        const Lane<Note> & lane() const
+        {
+            return m_lane;
+        }
+
+        Measure yBegin() const
+        {
+            return m_yBegin;
+        }
+
+        Measure yEnd() const
+        {
+            return m_yEnd;
+        }
+    };
+
     // Chart (header & body)
-    class EditableChart : public PlayableChart
+    //
+    // Undo/redo: snapshot() and restore() copy only the chunks modified since the last snapshot()/restore().
+    // addXXXNote()/eraseXXXNote() and the LaneEditor of editBTLane()/editFXLane()/editLaserLane() mark only the chunk of
+    // the edited y as modified. The non-const lane accessors mark the whole lane when called, so do not keep the returned
+    // reference across snapshot()/restore() (debug builds check in snapshot() and restore() that the unmarked chunks are unchanged).
+    //
+    // The structures derived from the FX and laser lanes (audio effect timelines, laser polylines and the lane spin track)
+    // are rebuilt by updateDerived(), snapshot() and restore() for the lanes modified since the last rebuild.
+    template <class Layout>
+    class BasicEditableChart : public BasicPlayableChart<Layout>
     {
+    private:
+        using Base = BasicPlayableChart<Layout>;
+
     public:
-        EditableChart(std::string_view filename) : PlayableChart(filename, true) {}
+        using typename Base::BTLanes;
+        using typename Base::FXLanes;
+        using typename Base::LaserLanes;
+        using Snapshot = BasicChartSnapshot<Layout>;
 
-        using PlayableChart::btLane;
-        using PlayableChart::fxLane;
-        using PlayableChart::laserLane;
-        using PlayableChart::btLanes;
-        using PlayableChart::fxLanes;
-        using PlayableChart::laserLanes;
+    private:
+        // Snapshot that the lanes are equal to (except dirty chunks)
+        Snapshot m_baseSnapshot;
+
+        std::array<DirtyChunks, Layout::BT_LANE_COUNT> m_btDirtyChunks;
+        std::array<DirtyChunks, Layout::FX_LANE_COUNT> m_fxDirtyChunks;
+        std::array<DirtyChunks, Layout::LASER_LANE_COUNT> m_laserDirtyChunks;
+
+        // Lanes whose derived structures are outdated
+        std::array<bool, Layout::FX_LANE_COUNT> m_fxDerivedDirty{};
+        bool m_laserDerivedDirty = false;
+
+        template <class DirtyChunksArray>
+        static void markAll(DirtyChunksArray & dirtyChunksArray)
+        {
+            for (auto & dirtyChunks : dirtyChunksArray)
+            {
+                dirtyChunks.markAll();
+            }
+        }
+
+        template <class Note>
+        static void addNote(Lane<Note> & lane, DirtyChunks & dirtyChunks, Measure y, const Note & note)
+        {
+            dirtyChunks.mark(y, y + 1);
+            lane.emplace(y, note);
+        }
+
+        template <class Note>
+        static bool eraseNote(Lane<Note> & lane, DirtyChunks & dirtyChunks, Measure y)
+        {
+            if (lane.erase(y) == 0)
+            {
+                return false;
+            }
+            dirtyChunks.mark(y, y + 1);
+            return true;
+        }
+
+    public:
+        BasicEditableChart(std::string_view filename, std::pmr::memory_resource * resource = std::pmr::get_default_resource()) : Base(filename, true, BodyLoadPolicy::Immediate, resource) {}
+
+        using Base::btLane;
+        using Base::fxLane;
+        using Base::laserLane;
+        using Base::btLanes;
+        using Base::fxLanes;
+        using Base::laserLanes;
 
         Lane<BTNote> & btLane(std::size_t idx)
         {
-            return m_btLanes.at(idx);
+            m_btDirtyChunks.at(idx).markAll();
+            return this->m_btLanes.at(idx);
         }
 
         Lane<FXNote> & fxLane(std::size_t idx)
         {
-            return m_fxLanes.at(idx);
+            m_fxDirtyChunks.at(idx).markAll();
+            m_fxDerivedDirty[idx] = true;
+            return this->m_fxLanes.at(idx);
         }
 
         Lane<LaserNote> & laserLane(std::size_t idx)
         {
-            return m_laserLanes.at(idx);
+            m_laserDirtyChunks.at(idx).markAll();
+            m_laserDerivedDirty = true;
+            return this->m_laserLanes.at(idx);
         }
 
-        std::vector<Lane<BTNote>> & btLanes()
+        BTLanes & btLanes()
         {
-            return m_btLanes;
+            markAll(m_btDirtyChunks);
+            return this->m_btLanes;
         }
 
-        std::vector<Lane<FXNote>> & fxLanes()
+        FXLanes & fxLanes()
         {
-            return m_fxLanes;
+            markAll(m_fxDirtyChunks);
+            m_fxDerivedDirty.fill(true);
+            return this->m_fxLanes;
         }
 
-        std::vector<Lane<LaserNote>> & laserLanes()
+        LaserLanes & laserLanes()
         {
-            return m_laserLanes;
+            markAll(m_laserDirtyChunks);
+            m_laserDerivedDirty = true;
+            return this->m_laserLanes;
+        }
+
+        // Add a note at y
+        void addBTNote(std::size_t idx, Measure y, const BTNote & note)
+        {
+            addNote(this->m_btLanes.at(idx), m_btDirtyChunks.at(idx), y, note);
+        }
+
+        void addFXNote(std::size_t idx, Measure y, const FXNote & note)
+        {
+            addNote(this->m_fxLanes.at(idx), m_fxDirtyChunks.at(idx), y, note);
+            m_fxDerivedDirty[idx] = true;
+        }
+
+        void addLaserNote(std::size_t idx, Measure y, const LaserNote & note)
+        {
+            addNote(this->m_laserLanes.at(idx), m_laserDirtyChunks.at(idx), y, note);
+            m_laserDerivedDirty = true;
+        }
+
+        // Remove the notes at y (returns false if there is none)
+        bool eraseBTNote(std::size_t idx, Measure y)
+        {
+            return eraseNote(this->m_btLanes.at(idx), m_btDirtyChunks.at(idx), y);
+        }
+
+        bool eraseFXNote(std::size_t idx, Measure y)
+        {
+            const bool erased = eraseNote(this->m_fxLanes.at(idx), m_fxDirtyChunks.at(idx), y);
+            m_fxDerivedDirty[idx] = m_fxDerivedDirty[idx] || erased;
+            return erased;
+        }
+
+        bool eraseLaserNote(std::size_t idx, Measure y)
+        {
+            const bool erased = eraseNote(this->m_laserLanes.at(idx), m_laserDirtyChunks.at(idx), y);
+            m_laserDerivedDirty = m_laserDerivedDirty || erased;
+            return erased;
+        }
+
+        // Editor for adding and removing only the notes whose y is in [yBegin, yEnd)
+        LaneEditor<BTNote> editBTLane(std::size_t idx, Measure yBegin, Measure yEnd)
+        {
+            return LaneEditor<BTNote>(this->m_btLanes.at(idx), m_btDirtyChunks.at(idx), nullptr, yBegin, yEnd);
+        }
+
+        LaneEditor<FXNote> editFXLane(std::size_t idx, Measure yBegin, Measure yEnd)
+        {
+            return LaneEditor<FXNote>(this->m_fxLanes.at(idx), m_fxDirtyChunks.at(idx), &m_fxDerivedDirty.at(idx), yBegin, yEnd);
+        }
+
+        LaneEditor<LaserNote> editLaserLane(std::size_t idx, Measure yBegin, Measure yEnd)
+        {
+            return LaneEditor<LaserNote>(this->m_laserLanes.at(idx), m_laserDirtyChunks.at(idx), &m_laserDerivedDirty, yBegin, yEnd);
+        }
+
+        // Rebuild the derived structures of the lanes modified since the last rebuild
+        void updateDerived()
+        {
+            for (std::size_t i = 0; i < Layout::FX_LANE_COUNT; ++i)
+            {
+                if (m_fxDerivedDirty[i])
+                {
+                    this->buildFXDerived(i);
+                    m_fxDerivedDirty[i] = false;
+                }
+            }
+            if (m_laserDerivedDirty)
+            {
+                this->buildLaserDerived();
+                m_laserDerivedDirty = false;
+            }
+        }
+
+        // Snapshot of the current lanes (shares unmodified chunks with the previous snapshot)
+        Snapshot snapshot()
+        {
+            updateDerived();
+            for (std::size_t i = 0; i < Layout::BT_LANE_COUNT; ++i)
+            {
+                assert(cleanChunksMatch(this->m_btLanes[i], m_baseSnapshot.btLanes[i], m_btDirtyChunks[i]) && "lane modified through a reference kept across snapshot()/restore()");
+                m_baseSnapshot.btLanes[i] = takeLaneSnapshot(this->m_btLanes[i], m_baseSnapshot.btLanes[i], m_btDirtyChunks[i]);
+                m_btDirtyChunks[i].clear();
+            }
+            for (std::size_t i = 0; i < Layout::FX_LANE_COUNT; ++i)
+            {
+                assert(cleanChunksMatch(this->m_fxLanes[i], m_baseSnapshot.fxLanes[i], m_fxDirtyChunks[i]) && "lane modified through a reference kept across snapshot()/restore()");
+                m_baseSnapshot.fxLanes[i] = takeLaneSnapshot(this->m_fxLanes[i], m_baseSnapshot.fxLanes[i], m_fxDirtyChunks[i]);
+                m_fxDirtyChunks[i].clear();
+            }
+            for (std::size_t i = 0; i < Layout::LASER_LANE_COUNT; ++i)
+            {
+                assert(cleanChunksMatch(this->m_laserLanes[i], m_baseSnapshot.laserLanes[i], m_laserDirtyChunks[i]) && "lane modified through a reference kept across snapshot()/restore()");
+                m_baseSnapshot.laserLanes[i] = takeLaneSnapshot(this->m_laserLanes[i], m_baseSnapshot.laserLanes[i], m_laserDirtyChunks[i]);
+                m_laserDirtyChunks[i].clear();
+            }
+            return m_baseSnapshot;
+        }
+
+        // Restore the lanes to a snapshot (copies only the chunks that differ from the current lanes)
+        void restore(const Snapshot & snapshot)
+        {
+            for (std::size_t i = 0; i < Layout::BT_LANE_COUNT; ++i)
+            {
+                assert(cleanChunksMatch(this->m_btLanes[i], m_baseSnapshot.btLanes[i], m_btDirtyChunks[i]) && "lane modified through a reference kept across snapshot()/restore()");
+                restoreLaneSnapshot(this->m_btLanes[i], m_baseSnapshot.btLanes[i], snapshot.btLanes[i], m_btDirtyChunks[i]);
+                m_btDirtyChunks[i].clear();
+            }
+            for (std::size_t i = 0; i < Layout::FX_LANE_COUNT; ++i)
+            {
+                assert(cleanChunksMatch(this->m_fxLanes[i], m_baseSnapshot.fxLanes[i], m_fxDirtyChunks[i]) && "lane modified through a reference kept across snapshot()/restore()");
+                if (restoreLaneSnapshot(this->m_fxLanes[i], m_baseSnapshot.fxLanes[i], snapshot.fxLanes[i], m_fxDirtyChunks[i]))
+                {
+                    m_fxDerivedDirty[i] = true;
+                }
+                m_fxDirtyChunks[i].clear();
+            }
+            for (std::size_t i = 0; i < Layout::LASER_LANE_COUNT; ++i)
+            {
+                assert(cleanChunksMatch(this->m_laserLanes[i], m_baseSnapshot.laserLanes[i], m_laserDirtyChunks[i]) && "lane modified through a reference kept across snapshot()/restore()");
+                if (restoreLaneSnapshot(this->m_laserLanes[i], m_baseSnapshot.laserLanes[i], snapshot.laserLanes[i], m_laserDirtyChunks[i]))
+                {
+                    m_laserDerivedDirty = true;
+                }
+                m_laserDirtyChunks[i].clear();
+            }
+            m_baseSnapshot = snapshot;
+            updateDerived();
         }
     };
 
+    using EditableChart = BasicEditableChart<DefaultLaneLayout>;
+
 }
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace ksh
+{
+
+    // Length of the leading run of ASCII bytes (checks 16-32 bytes at a time)
+    std::size_t asciiPrefixLength(const char * data, std::size_t size);
+
+    inline bool isASCII(std::string_view str)
+    {
+        return asciiPrefixLength(str.data(), str.size()) == str.size();
+    }
+
+    // Append Shift_JIS (CP932) text to a UTF-8 string (unmapped characters become U+FFFD)
+    void appendShiftJISAsUTF8(std::string & dest, std::string_view shiftJISStr);
+
+    std::string shiftJISToUTF8(std::string_view shiftJISStr);
+
+}
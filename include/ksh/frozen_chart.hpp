@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <utility>
+
+#include "ksh/playable_chart.hpp"
+
+namespace ksh
+{
+
+    // Immutable snapshot of a fully loaded chart shared between threads without copying
+    //
+    // The body is always loaded before the snapshot is created, so const access only does an atomic
+    // acquire load in BasicPlayableChart::loadBody() and never takes a lock. Copies share the same chart.
+    template <class Layout>
+    class BasicFrozenChart
+    {
+    public:
+        using ChartType = BasicPlayableChart<Layout>;
+
+    private:
+        std::shared_ptr<const ChartType> m_chart;
+
+        explicit BasicFrozenChart(std::shared_ptr<const ChartType> && chart)
+            : m_chart(std::move(chart))
+        {
+        }
+
+    public:
+        // Load a chart file into a snapshot
+        static BasicFrozenChart load(std::string_view filename)
+        {
+            return BasicFrozenChart(std::make_shared<const ChartType>(filename, BodyLoadPolicy::Immediate));
+        }
+
+        // Take ownership of a chart (the body is loaded here if it has not been loaded yet)
+        static BasicFrozenChart freeze(std::unique_ptr<ChartType> && chart)
+        {
+            chart->loadBody();
+            return BasicFrozenChart(std::shared_ptr<const ChartType>(std::move(chart)));
+        }
+
+        const ChartType & operator*() const
+        {
+            return *m_chart;
+        }
+
+        const ChartType * operator->() const
+        {
+            return m_chart.get();
+        }
+
+        const ChartType & get() const
+        {
+            return *m_chart;
+        }
+
+        // Shared ownership of the chart (e.g. for objects that outlive the snapshot)
+        const std::shared_ptr<const ChartType> & sharedChart() const
+        {
+            return m_chart;
+        }
+    };
+
+    using FrozenChart = BasicFrozenChart<DefaultLaneLayout>;
+
+}
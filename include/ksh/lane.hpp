@@ -0,0 +1,16 @@
+#pragma once
+
+#include <map>
+#include <memory_resource>
+
+#include "ksh/beat_map/time_sig.hpp"
+
+namespace ksh
+{
+
+    // Notes of a lane by y
+    // (allocator-aware: notes inserted into a lane allocate their judgments from the memory resource of the lane)
+    template <class Note>
+    using Lane = std::pmr::multimap<Measure, Note>;
+
+}
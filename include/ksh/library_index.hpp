@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+#include "ksh/playable_chart.hpp"
+
+namespace ksh
+{
+
+    // Header meta data and derived stats of a chart file
+    struct LibraryIndexEntry
+    {
+    public:
+        // Key of the entry (the entry is reused while the file size and the modified time are unchanged)
+        std::string filename;
+        uint64_t fileSize = 0;
+        int64_t modifiedTime = 0; // In ns since the Unix epoch
+
+        std::unordered_map<std::string, std::string> metaData;
+
+        std::size_t comboCount = 0;
+        Ms durationMs = 0.0; // End of the last note
+        double minTempo = 0.0;
+        double maxTempo = 0.0;
+    };
+
+    // Persistent index of chart files for song select
+    class LibraryIndex
+    {
+    private:
+        std::unordered_map<std::string, LibraryIndexEntry> m_entries;
+
+    public:
+        struct RefreshResult
+        {
+            std::size_t reusedCount = 0;
+            std::size_t parsedCount = 0;
+            std::size_t removedCount = 0;
+            std::vector<std::string> failedFilenames;
+        };
+
+        LibraryIndex() = default;
+
+        // Load an index file saved by save() (an index file that is missing, broken or outdated results in an empty index)
+        explicit LibraryIndex(std::string_view indexFilename);
+
+        bool save(std::string_view indexFilename) const;
+
+        // Synchronize the index with the given chart files
+        // (only stats each file; charts whose size or modified time changed are parsed on threadCount threads, 0 = all cores)
+        RefreshResult refresh(const std::vector<std::string> & chartFilenames, std::size_t threadCount = 0);
+
+        // Same as refresh() with all .ksh files under the directory (recursive)
+        RefreshResult refreshDirectory(std::string_view directoryPath, std::size_t threadCount = 0);
+
+        const LibraryIndexEntry * find(const std::string & chartFilename) const;
+
+        const std::unordered_map<std::string, LibraryIndexEntry> & entries() const
+        {
+            return m_entries;
+        }
+
+        std::size_t size() const
+        {
+            return m_entries.size();
+        }
+
+        // Returns false if the chart cannot be loaded (the chart has an error diagnostic)
+        static bool createEntry(const std::string & chartFilename, uint64_t fileSize, int64_t modifiedTime, LibraryIndexEntry & entry);
+    };
+
+}
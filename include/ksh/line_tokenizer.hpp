@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ksh
+{
+
+    enum class LineKind : uint8_t
+    {
+        Other,      // Empty line or unknown line
+        Comment,    // Starts with ";" or "//"
+        Definition, // Starts with "#" (user-defined audio effects)
+        Chart,      // Contains "|"
+        Option,     // Contains "="
+        BarLine,    // "--"
+    };
+
+    struct TokenizedLine
+    {
+    public:
+        uint32_t offset;
+        uint32_t length; // Excludes CR/LF
+        LineKind kind;
+
+        std::string_view view(std::string_view buffer) const
+        {
+            return buffer.substr(offset, length);
+        }
+    };
+
+    // Split a chart body into lines and classify them in one pass (16 bytes at a time with SSE2)
+    // (the buffer must be smaller than 4 GiB)
+    void tokenizeLines(std::string_view buffer, std::vector<TokenizedLine> & lines);
+
+    std::vector<TokenizedLine> tokenizeLines(std::string_view buffer);
+
+}
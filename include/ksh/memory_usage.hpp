@@ -0,0 +1,116 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <initializer_list>
+#include <cstddef>
+
+namespace ksh
+{
+
+    // Heap memory of a component
+    // (node sizes assume a red-black tree node with three pointers and a color, and a singly linked hash node with a cached hash,
+    //  as in libstdc++/libc++; each allocation is rounded up as in glibc malloc, so allocatedBytes is an estimate for
+    //  malloc-backed memory resources only: with an arena such as std::pmr::monotonic_buffer_resource, usedBytes is closer)
+    struct MemoryUsage
+    {
+    public:
+        std::size_t allocatedBytes = 0; // Including unused capacity and allocator overhead
+        std::size_t usedBytes = 0;      // Live elements only
+        std::size_t elementCount = 0;
+
+        MemoryUsage & operator+=(const MemoryUsage & rhs)
+        {
+            allocatedBytes += rhs.allocatedBytes;
+            usedBytes += rhs.usedBytes;
+            elementCount += rhs.elementCount;
+            return *this;
+        }
+
+        MemoryUsage operator+(const MemoryUsage & rhs) const
+        {
+            MemoryUsage usage = *this;
+            usage += rhs;
+            return usage;
+        }
+    };
+
+    // Size of a heap block including the allocator overhead (estimate of glibc malloc)
+    std::size_t heapBlockBytes(std::size_t requestedBytes);
+
+    // Heap memory of the string (zero if it fits in the small string buffer)
+    template <class String>
+    MemoryUsage stringMemoryUsage(const String & str)
+    {
+        // Small strings are stored inside the string object
+        const char * data = str.data();
+        const char * object = reinterpret_cast<const char *>(&str);
+        if (data >= object && data < object + sizeof(String))
+        {
+            return MemoryUsage{ 0, 0, 1 };
+        }
+        return MemoryUsage{ heapBlockBytes(str.capacity() + 1), str.size() + 1, 1 };
+    }
+
+    constexpr std::size_t TREE_NODE_OVERHEAD = sizeof(void *) * 3 + sizeof(int); // parent, left, right and color
+    constexpr std::size_t HASH_NODE_OVERHEAD = sizeof(void *) + sizeof(std::size_t); // next and cached hash
+
+    // Heap memory of the tree nodes (not including the heap memory owned by the elements)
+    template <class Map>
+    MemoryUsage treeMemoryUsage(const Map & map)
+    {
+        constexpr std::size_t nodeBytes = TREE_NODE_OVERHEAD + sizeof(typename Map::value_type);
+        return MemoryUsage{ heapBlockBytes(nodeBytes) * map.size(), sizeof(typename Map::value_type) * map.size(), map.size() };
+    }
+
+    // Heap memory of the hash nodes and the bucket array (not including the heap memory owned by the elements)
+    template <class Map>
+    MemoryUsage hashMemoryUsage(const Map & map)
+    {
+        constexpr std::size_t nodeBytes = HASH_NODE_OVERHEAD + sizeof(typename Map::value_type);
+        return MemoryUsage{
+            heapBlockBytes(nodeBytes) * map.size() + ((map.bucket_count() > 1) ? heapBlockBytes(sizeof(void *) * map.bucket_count()) : 0),
+            sizeof(typename Map::value_type) * map.size(),
+            map.size(),
+        };
+    }
+
+    // Heap memory of the vector buffer (not including the heap memory owned by the elements)
+    template <typename T, class Allocator>
+    MemoryUsage vectorMemoryUsage(const std::vector<T, Allocator> & vec)
+    {
+        return MemoryUsage{ (vec.capacity() > 0) ? heapBlockBytes(sizeof(T) * vec.capacity()) : 0, sizeof(T) * vec.size(), vec.size() };
+    }
+
+    // Breakdown of PlayableChart::memoryUsage()
+    struct ChartMemoryUsage
+    {
+    public:
+        bool bodyLoaded = true;              // false = only objectBytes and metaData are counted (body not loaded yet)
+        std::size_t objectBytes = 0;         // The chart object itself, its file stream and file paths
+        MemoryUsage metaData;                // Header ("title=" etc.)
+        MemoryUsage beatMap;                 // BeatMap::memoryUsage() (a beat map shared between charts is counted by each of them)
+        MemoryUsage btLanes;                 // Lane nodes
+        MemoryUsage fxLanes;                 // Lane nodes
+        MemoryUsage laserLanes;              // Lane nodes
+        MemoryUsage noteJudgments;           // Judgment maps of all notes
+        MemoryUsage fxAudioEffectStrs;       // Audio effect strings of FX notes
+        MemoryUsage lineGraphs;              // zoom_top, zoom_bottom, zoom_side, center_split and manual tilt
+        MemoryUsage positionalOptions;       // PlayableChart::positionalOptions()
+        MemoryUsage derived;                 // Structures built at load time (laser polylines, timelines, tracks, audio effects)
+        MemoryUsage diagnostics;             // Chart::diagnostics() (counted only if the body is loaded, as parsing the body adds to them)
+
+        MemoryUsage total() const
+        {
+            MemoryUsage usage{ objectBytes, objectBytes, 0 };
+            for (const MemoryUsage * component : { &metaData, &beatMap, &btLanes, &fxLanes, &laserLanes, &noteJudgments, &fxAudioEffectStrs, &lineGraphs, &positionalOptions, &derived, &diagnostics })
+            {
+                usage += *component;
+            }
+            return usage;
+        }
+    };
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace ksh
+{
+
+    // Option keys known by the parser
+    enum class OptionKey : uint8_t
+    {
+        Unknown,
+        Tempo,          // t
+        Beat,           // beat
+        Stop,           // stop
+        ZoomTop,        // zoom_top
+        ZoomBottom,     // zoom_bottom
+        ZoomSide,       // zoom_side
+        CenterSplit,    // center_split
+        Tilt,           // tilt
+        LaserRangeL,    // laserrange_l
+        LaserRangeR,    // laserrange_r
+        FXL,            // fx-l
+        FXR,            // fx-r
+        FXLParam1,      // fx-l_param1
+        FXRParam1,      // fx-r_param1
+        FilterType,     // filtertype
+        PFilterGain,    // pfiltergain
+        ChokkakuVol,    // chokkakuvol
+        ChokkakuSE,     // chokkakuse
+        LaneToggle,     // lane_toggle
+    };
+
+    constexpr std::size_t OPTION_KEY_COUNT = static_cast<std::size_t>(OptionKey::LaneToggle) + 1;
+
+    // FNV-1a
+    constexpr uint32_t hashOptionKey(std::string_view key)
+    {
+        uint32_t hash = 2166136261u;
+        for (std::size_t i = 0; i < key.size(); ++i)
+        {
+            hash ^= static_cast<unsigned char>(key[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    // Option key string to OptionKey with one hash and one string comparison
+    // (duplicate case labels fail to compile, so the hash is guaranteed to be perfect for the known keys)
+    constexpr OptionKey toOptionKey(std::string_view key)
+    {
+        const auto match = [key](std::string_view name, OptionKey optionKey)
+        {
+            return (key == name) ? optionKey : OptionKey::Unknown;
+        };
+
+        switch (hashOptionKey(key))
+        {
+        case hashOptionKey("t"):            return match("t", OptionKey::Tempo);
+        case hashOptionKey("beat"):         return match("beat", OptionKey::Beat);
+        case hashOptionKey("stop"):         return match("stop", OptionKey::Stop);
+        case hashOptionKey("zoom_top"):     return match("zoom_top", OptionKey::ZoomTop);
+        case hashOptionKey("zoom_bottom"):  return match("zoom_bottom", OptionKey::ZoomBottom);
+        case hashOptionKey("zoom_side"):    return match("zoom_side", OptionKey::ZoomSide);
+        case hashOptionKey("center_split"): return match("center_split", OptionKey::CenterSplit);
+        case hashOptionKey("tilt"):         return match("tilt", OptionKey::Tilt);
+        case hashOptionKey("laserrange_l"): return match("laserrange_l", OptionKey::LaserRangeL);
+        case hashOptionKey("laserrange_r"): return match("laserrange_r", OptionKey::LaserRangeR);
+        case hashOptionKey("fx-l"):         return match("fx-l", OptionKey::FXL);
+        case hashOptionKey("fx-r"):         return match("fx-r", OptionKey::FXR);
+        case hashOptionKey("fx-l_param1"):  return match("fx-l_param1", OptionKey::FXLParam1);
+        case hashOptionKey("fx-r_param1"):  return match("fx-r_param1", OptionKey::FXRParam1);
+        case hashOptionKey("filtertype"):   return match("filtertype", OptionKey::FilterType);
+        case hashOptionKey("pfiltergain"):  return match("pfiltergain", OptionKey::PFilterGain);
+        case hashOptionKey("chokkakuvol"):  return match("chokkakuvol", OptionKey::ChokkakuVol);
+        case hashOptionKey("chokkakuse"):   return match("chokkakuse", OptionKey::ChokkakuSE);
+        case hashOptionKey("lane_toggle"):  return match("lane_toggle", OptionKey::LaneToggle);
+        default:                            return OptionKey::Unknown;
+        }
+    }
+
+    static_assert(toOptionKey("zoom_top") == OptionKey::ZoomTop, "toOptionKey() must be usable at compile time");
+    static_assert(toOptionKey("zoom_to") == OptionKey::Unknown, "toOptionKey() must reject unknown keys");
+
+}
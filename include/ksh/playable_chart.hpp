@@ -1,114 +1,320 @@
 #pragma once
 
 #include <string>
-#include <vector>
+#include <array>
 #include <map>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <atomic>
+#include <future>
 #include <cstddef>
 
+#include "ksh/lane.hpp"
 #include "ksh/chart.hpp"
+#include "ksh/memory_usage.hpp"
+#include "ksh/camera_timeline.hpp"
+#include "ksh/audio_effect_timeline.hpp"
+#include "ksh/positional_option_tracks.hpp"
+#include "ksh/scroll_timeline.hpp"
 #include "ksh/beat_map/beat_map.hpp"
+#include "ksh/beat_map/beat_grid.hpp"
 #include "ksh/chart_object/bt_note.hpp"
 #include "ksh/chart_object/fx_note.hpp"
 #include "ksh/chart_object/laser_note.hpp"
 #include "ksh/chart_object/line_graph.hpp"
+#include "ksh/chart_object/laser_polyline.hpp"
+#include "ksh/chart_object/lane_spin_track.hpp"
 
 namespace ksh
 {
 
-    template <class Note>
-    using Lane = std::multimap<Measure, Note>;
+    // Number of lanes of each note type (fixed at compile time)
+    template <std::size_t BTLaneCount, std::size_t FXLaneCount, std::size_t LaserLaneCount>
+    struct LaneLayout
+    {
+        static constexpr std::size_t BT_LANE_COUNT = BTLaneCount;
+        static constexpr std::size_t FX_LANE_COUNT = FXLaneCount;
+        static constexpr std::size_t LASER_LANE_COUNT = LaserLaneCount;
+    };
+
+    using DefaultLaneLayout = LaneLayout<4, 2, 2>;
+
+    // Experimental 6-BT layout ("000000|00|--")
+    using SixBTLaneLayout = LaneLayout<6, 2, 2>;
+
+    enum class BodyLoadPolicy
+    {
+        Immediate, // Parse the body in the constructor
+        OnDemand,  // Parse the body on the first access to body data (or on loadBody()/loadBodyAsync())
+    };
 
     // Chart (header & body)
-    class PlayableChart : public Chart
+    // (BasicPlayableChart is explicitly instantiated for DefaultLaneLayout and SixBTLaneLayout)
+    // Const member functions can be called concurrently (the body is parsed once with std::call_once and
+    // never modified afterwards); use BasicFrozenChart to share a chart between threads
+    template <class Layout>
+    class BasicPlayableChart : public Chart
     {
+        static_assert(Layout::FX_LANE_COUNT >= 2, "fx-l/fx-r options need two FX lanes");
+
+    public:
+        using LaneLayoutType = Layout;
+        using BodyLoadPolicy = ksh::BodyLoadPolicy;
+
+        using BTLanes = std::array<Lane<BTNote>, Layout::BT_LANE_COUNT>;
+        using FXLanes = std::array<Lane<FXNote>, Layout::FX_LANE_COUNT>;
+        using LaserLanes = std::array<Lane<LaserNote>, Layout::LASER_LANE_COUNT>;
+        using LaserPolylines = std::array<LaserPolyline, Layout::LASER_LANE_COUNT>;
+        using AudioEffectTimelines = std::array<AudioEffectTimeline, Layout::FX_LANE_COUNT>;
+
     private:
-        bool insertTempoChange(std::map<Measure, double> & tempoChanges, Measure y, const std::string & value);
+        struct BodyLoadState
+        {
+            std::once_flag onceFlag;
+            std::atomic<bool> loaded{ false };
+        };
+
+        const bool m_isEditor;
+        std::pmr::memory_resource * const m_resource;
+        std::unique_ptr<BodyLoadState> m_bodyLoadState; // uses unique_ptr to make PlayableChart objects move constructible
+
+        void parseBody() const;
 
     protected:
-        std::unique_ptr<BeatMap> m_beatMap;
-        std::vector<Lane<BTNote>> m_btLanes;
-        std::vector<Lane<FXNote>> m_fxLanes;
-        std::vector<Lane<LaserNote>> m_laserLanes;
-        LineGraph m_zoomTop;
-        LineGraph m_zoomBottom;
-        LineGraph m_zoomSide;
-        LineGraph m_centerSplit;
-        LineGraph m_manualTilt;
-        std::unordered_map<std::string, std::map<Measure, std::string>> m_positionalOptions;
-        PlayableChart(std::string_view filename, bool isEditor);
+        // Body data (mutable because it is filled on the first access in BodyLoadPolicy::OnDemand)
+        mutable std::shared_ptr<const BeatMap> m_beatMap; // (can be shared with other charts; see shareBeatMap())
+        mutable BTLanes m_btLanes;
+        mutable FXLanes m_fxLanes;
+        mutable LaserLanes m_laserLanes;
+        mutable LineGraph m_zoomTop;
+        mutable LineGraph m_zoomBottom;
+        mutable LineGraph m_zoomSide;
+        mutable LineGraph m_centerSplit;
+        mutable LineGraph m_manualTilt;
+        mutable PositionalOptions m_positionalOptions;
+
+        // Derived from body data at load time
+        mutable BeatGrid m_beatGrid;
+        mutable LaserPolylines m_laserPolylines;
+        mutable LaneSpinTrack m_laneSpinTrack;
+        mutable CameraTimeline m_cameraTimeline;
+        mutable PositionalOptionTracks m_optionTracks;
+        mutable ScrollTimeline m_scrollTimeline;
+        mutable AudioEffectTable m_audioEffects;
+        mutable AudioEffectTimelines m_audioEffectTimelines;
+
+        // Build the derived structures of the laser lanes (polylines and the lane spin track) from the current lanes
+        void buildLaserDerived() const;
+
+        // Build the audio effect timeline of an FX lane from the current lane
+        void buildFXDerived(std::size_t laneIdx) const;
+
+        BasicPlayableChart(std::string_view filename, bool isEditor, BodyLoadPolicy bodyLoadPolicy = BodyLoadPolicy::Immediate, std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 
     public:
-        PlayableChart(std::string_view filename) : PlayableChart(filename, false) {}
+        // Containers of the chart (metadata, beat map, lanes and note judgments, line graphs and positional options) allocate from resource
+        // (e.g. std::pmr::monotonic_buffer_resource to place a chart in one arena; resource must outlive the chart)
+        BasicPlayableChart(std::string_view filename, std::pmr::memory_resource * resource = std::pmr::get_default_resource()) : BasicPlayableChart(filename, false, BodyLoadPolicy::Immediate, resource) {}
 
-        virtual ~PlayableChart() = default;
+        BasicPlayableChart(std::string_view filename, BodyLoadPolicy bodyLoadPolicy, std::pmr::memory_resource * resource = std::pmr::get_default_resource()) : BasicPlayableChart(filename, false, bodyLoadPolicy, resource) {}
+
+        virtual ~BasicPlayableChart() = default;
+
+        // Parse the body if not parsed yet (thread-safe; body accessors call this implicitly)
+        void loadBody() const
+        {
+            if (!isBodyLoaded())
+            {
+                std::call_once(m_bodyLoadState->onceFlag, [this]() {
+                    parseBody();
+                    m_bodyLoadState->loaded.store(true, std::memory_order_release);
+                });
+            }
+        }
+
+        // Parse the body on a background thread (the chart must outlive the returned future)
+        std::future<void> loadBodyAsync() const;
+
+        bool isBodyLoaded() const
+        {
+            return m_bodyLoadState->loaded.load(std::memory_order_acquire);
+        }
+
+        std::pmr::memory_resource * memoryResource() const
+        {
+            return m_resource;
+        }
+
+        // Problems found while parsing the header and the body
+        const std::vector<Diagnostic> & diagnostics() const override
+        {
+            loadBody();
+            return m_diagnostics;
+        }
 
         const BeatMap & beatMap() const
         {
+            loadBody();
             return *m_beatMap;
         }
 
+        // Shared ownership of the beat map (e.g. to pass it to shareBeatMap() of another difficulty)
+        std::shared_ptr<const BeatMap> sharedBeatMap() const
+        {
+            loadBody();
+            return m_beatMap;
+        }
+
+        // Replace the beat map with an equivalent one owned by another chart to save memory
+        // (returns false and keeps the current one if they are not equivalent or beatMap is allocated from another memory
+        // resource than this chart; not thread-safe, so call this before sharing the chart between threads)
+        bool shareBeatMap(const std::shared_ptr<const BeatMap> & beatMap);
+
+        // Bar lines and beat lines of all measures in the chart
+        const BeatGrid & beatGrid() const
+        {
+            loadBody();
+            return m_beatGrid;
+        }
+
         const Lane<BTNote> & btLane(std::size_t idx) const
         {
+            loadBody();
             return m_btLanes.at(idx);
         }
 
         const Lane<FXNote> & fxLane(std::size_t idx) const
         {
+            loadBody();
             return m_fxLanes.at(idx);
         }
 
         const Lane<LaserNote> & laserLane(std::size_t idx) const
         {
+            loadBody();
             return m_laserLanes.at(idx);
         }
 
-        const std::vector<Lane<BTNote>> & btLanes() const
+        const BTLanes & btLanes() const
         {
+            loadBody();
             return m_btLanes;
         }
 
-        const std::vector<Lane<FXNote>> & fxLanes() const
+        const FXLanes & fxLanes() const
         {
+            loadBody();
             return m_fxLanes;
         }
 
-        const std::vector<Lane<LaserNote>> & laserLanes() const
+        const LaserLanes & laserLanes() const
         {
+            loadBody();
             return m_laserLanes;
         }
 
+        const LaserPolyline & laserPolyline(std::size_t idx) const
+        {
+            loadBody();
+            return m_laserPolylines.at(idx);
+        }
+
+        const LaserPolylines & laserPolylines() const
+        {
+            loadBody();
+            return m_laserPolylines;
+        }
+
+        const AudioEffectTable & audioEffects() const
+        {
+            loadBody();
+            return m_audioEffects;
+        }
+
+        const AudioEffectTimeline & audioEffectTimeline(std::size_t idx) const
+        {
+            loadBody();
+            return m_audioEffectTimelines.at(idx);
+        }
+
+        const AudioEffectTimelines & audioEffectTimelines() const
+        {
+            loadBody();
+            return m_audioEffectTimelines;
+        }
+
+        const LaneSpinTrack & laneSpinTrack() const
+        {
+            loadBody();
+            return m_laneSpinTrack;
+        }
+
         const LineGraph & zoomTop() const
         {
+            loadBody();
             return m_zoomTop;
         }
 
         const LineGraph & zoomBottom() const
         {
+            loadBody();
             return m_zoomBottom;
         }
 
         const LineGraph & zoomSide() const
         {
+            loadBody();
             return m_zoomSide;
         }
 
         const LineGraph & centerSplit() const
         {
+            loadBody();
             return m_centerSplit;
         }
 
         const LineGraph & manualTilt() const
         {
+            loadBody();
             return m_manualTilt;
         }
 
-        const std::unordered_map<std::string, std::map<Measure, std::string>> & positionalOptions() const
+        const CameraTimeline & cameraTimeline() const
         {
+            loadBody();
+            return m_cameraTimeline;
+        }
+
+        const PositionalOptionTracks & optionTracks() const
+        {
+            loadBody();
+            return m_optionTracks;
+        }
+
+        // Scroll position of the highway (tempo changes and stops applied)
+        const ScrollTimeline & scrollTimeline() const
+        {
+            loadBody();
+            return m_scrollTimeline;
+        }
+
+        const PositionalOptions & positionalOptions() const
+        {
+            loadBody();
             return m_positionalOptions;
         }
 
         std::size_t comboCount() const;
+
+        // Heap memory broken down by component
+        // (does not load the body; only the object and the header are counted if the body is not loaded yet)
+        ChartMemoryUsage memoryUsage() const;
     };
 
+    using PlayableChart = BasicPlayableChart<DefaultLaneLayout>;
+
+    extern template class BasicPlayableChart<DefaultLaneLayout>;
+    extern template class BasicPlayableChart<SixBTLaneLayout>;
+
 }
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "ksh/playable_chart.hpp"
+#include "ksh/spsc_ring_buffer.hpp"
+
+namespace ksh
+{
+
+    // Events at the same time are ordered by this type
+    enum class PlaybackEventType : uint8_t
+    {
+        TempoChange,      // value = tempo
+        AudioEffectEnd,   // lane = FX lane
+        AudioEffectStart, // lane = FX lane, param = AudioEffectTable::Index
+        FilterTypeChange, // param = FilterType ("filtertype=")
+        FilterGainChange, // value = gain in [0, 1] ("pfiltergain=")
+        SlamSound,        // lane = laser lane, param = SlamSound, value = volume in [0, 1] ("chokkakuse=" and "chokkakuvol=")
+    };
+
+    struct PlaybackEvent
+    {
+    public:
+        Ms ms;
+        double value;
+        uint32_t generation; // Incremented by PlaybackScheduler::seek()
+        PlaybackEventType type;
+        uint8_t lane;
+        uint16_t param;
+    };
+
+    // Chart events sorted in ms at load time and handed off from the game thread to the audio thread
+    // with a wait-free SPSC ring buffer (no allocation and no lock after construction)
+    //
+    // Game thread:  pump() and seek()
+    // Audio thread: popUntil()
+    class PlaybackScheduler
+    {
+    public:
+        static constexpr std::size_t QUEUE_CAPACITY = 1024;
+
+    private:
+        // Events that set one piece of state restored by seek() (tempo, filter type, filter gain, or the audio effect of one FX lane)
+        struct StateTrack
+        {
+        public:
+            std::vector<std::size_t> eventIdxs; // Indices in m_events (sorted)
+            PlaybackEvent initialEvent;         // State before the first event
+        };
+
+        std::vector<PlaybackEvent> m_events; // Sorted by ms (and type)
+        std::vector<StateTrack> m_stateTracks;
+        const Ms m_lookAheadMs;
+
+        // Game thread only
+        std::size_t m_nextEventIdx = 0;
+        std::vector<PlaybackEvent> m_stateEvents; // State at the seek position, queued before m_events (one per state track)
+        std::size_t m_nextStateEventIdx = 0;
+
+        // Queue the rest of m_stateEvents (returns false if the queue is full)
+        bool pushStateEvents(std::size_t & count);
+
+        std::atomic<uint32_t> m_generation{ 0 };
+
+        SPSCRingBuffer<PlaybackEvent, QUEUE_CAPACITY> m_queue;
+
+    public:
+        template <class Layout>
+        explicit PlaybackScheduler(const BasicPlayableChart<Layout> & chart, Ms lookAheadMs = 100.0);
+
+        PlaybackScheduler(const PlaybackScheduler &) = delete;
+
+        PlaybackScheduler & operator=(const PlaybackScheduler &) = delete;
+
+        // Game thread: queue the events before currentMs + lookAheadMs (returns the number of queued events)
+        // Stops early if the queue is full; the rest is queued by the next call
+        std::size_t pump(Ms currentMs);
+
+        // Game thread: restart from ms (events already queued are dropped by popUntil())
+        // The tempo, filter and audio effects in effect at ms are queued first as events at ms (no allocation)
+        void seek(Ms ms);
+
+        // Audio thread: pop the next event before endMs (returns false if there is none yet)
+        bool popUntil(Ms endMs, PlaybackEvent & event);
+
+        const std::vector<PlaybackEvent> & events() const
+        {
+            return m_events;
+        }
+
+        Ms lookAheadMs() const
+        {
+            return m_lookAheadMs;
+        }
+    };
+
+    extern template PlaybackScheduler::PlaybackScheduler(const BasicPlayableChart<DefaultLaneLayout> &, Ms);
+    extern template PlaybackScheduler::PlaybackScheduler(const BasicPlayableChart<SixBTLaneLayout> &, Ms);
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <map>
+#include <array>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <memory_resource>
+#include <cstddef>
+#include <cstdint>
+
+#include "ksh/option_key.hpp"
+#include "ksh/beat_map/beat_map.hpp"
+
+namespace ksh
+{
+
+    enum class OptionValueType : uint8_t
+    {
+        None,     // Not stored in PositionalOptionTracks (unknown keys and keys handled by the parser itself)
+        Numeric,  // Point::value is the number
+        Enum,     // Point::value is the enumerator (see enumValue())
+        Duration, // Point::value is the length in Measure, Point::durationMs is the length in ms
+    };
+
+    OptionValueType optionValueType(OptionKey key);
+
+    // "laserrange_l=" / "laserrange_r="
+    enum class LaserRange : int
+    {
+        Normal, // 1x
+        Wide,   // 2x
+    };
+
+    // "filtertype="
+    enum class FilterType : int
+    {
+        Peak,       // peak
+        LowPass,    // lpf1
+        HighPass,   // hpf1
+        BitCrusher, // bitc
+        Custom,     // User-defined filter (the name is in PlayableChart::positionalOptions())
+    };
+
+    // "chokkakuse="
+    enum class SlamSound : int
+    {
+        Down,
+        Up,
+        Swing,
+        Mute,
+    };
+
+    // Positional options by key (values by y)
+    using PositionalOptions = std::pmr::unordered_map<std::pmr::string, std::pmr::map<Measure, std::pmr::string>>;
+
+    // Known positional options parsed into typed tracks with ms (unknown keys stay in PlayableChart::positionalOptions() only)
+    class PositionalOptionTracks
+    {
+    public:
+        struct Point
+        {
+        public:
+            Measure y;
+            Ms ms;
+            double value;
+            Ms durationMs; // OptionValueType::Duration only
+
+            template <typename Enum>
+            Enum enumValue() const
+            {
+                return static_cast<Enum>(static_cast<int>(value));
+            }
+        };
+
+        using Track = std::vector<Point>; // Sorted by y
+
+    private:
+        std::array<Track, OPTION_KEY_COUNT> m_tracks;
+
+        static const Track s_emptyTrack;
+
+    public:
+        PositionalOptionTracks() = default;
+
+        PositionalOptionTracks(const PositionalOptions & positionalOptions, const BeatMap & beatMap);
+
+        const Track & track(OptionKey key) const
+        {
+            return (optionValueType(key) == OptionValueType::None) ? s_emptyTrack : m_tracks[static_cast<std::size_t>(key)];
+        }
+
+        // Last point at or before y (nullptr if none)
+        const Point * pointAt(OptionKey key, Measure y) const;
+
+        MemoryUsage memoryUsage() const;
+    };
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "ksh/beat_map/beat_map.hpp"
+#include "ksh/memory_usage.hpp"
+#include "ksh/positional_option_tracks.hpp"
+
+namespace ksh
+{
+
+    // Visual scroll position of the highway as a piecewise-linear function (structure of arrays)
+    //
+    // The distance is in ms at the reference tempo: it advances by tempo / referenceTempo per ms and stays
+    // constant during "stop=" intervals. A note is drawn at (distance of the note - distance of now) * hi-speed.
+    // Tempo changes and the starts and ends of stops are the breakpoints (overlapping stops are merged).
+    class ScrollTimeline
+    {
+    public:
+        // Sequential sampler for monotonically increasing time (O(1) amortized; also works backward with a binary search)
+        class Cursor
+        {
+        private:
+            const ScrollTimeline * m_timeline;
+            std::size_t m_idx;
+
+        public:
+            explicit Cursor(const ScrollTimeline & timeline) : m_timeline(&timeline), m_idx(0) {}
+
+            double distanceAt(Ms ms);
+        };
+
+    private:
+        double m_referenceTempo = 120.0;
+        double m_distancePerMeasure = 0.0; // Outside stops (constant because the distance is proportional to the beat count)
+
+        // Breakpoints (the first one is at y = 0; values before it are extrapolated)
+        std::vector<Measure> m_breakpointYs;
+        std::vector<Ms> m_breakpointMs;
+        std::vector<double> m_distances;  // Distance at each breakpoint
+        std::vector<double> m_slopes;     // Distance per ms after each breakpoint (0 in stops)
+
+        std::size_t intervalIdxAtMeasure(Measure y) const;
+
+        std::size_t intervalIdxAt(Ms ms) const;
+
+        double distanceAtMeasure(std::size_t idx, Measure y) const
+        {
+            return (m_slopes[idx] == 0.0) ? m_distances[idx] : m_distances[idx] + (y - m_breakpointYs[idx]) * m_distancePerMeasure;
+        }
+
+        double distanceAt(std::size_t idx, Ms ms) const
+        {
+            return m_distances[idx] + (ms - m_breakpointMs[idx]) * m_slopes[idx];
+        }
+
+    public:
+        ScrollTimeline() = default;
+
+        // stops: OptionKey::Stop track of PositionalOptionTracks
+        ScrollTimeline(const BeatMap & beatMap, const PositionalOptionTracks::Track & stops, double referenceTempo);
+
+        double distanceAt(Ms ms) const;
+
+        double distanceAtMeasure(Measure y) const;
+
+        // distanceAt() for many times at once (one linear pass when ms values are sorted)
+        void distancesAt(const Ms * ms, double * dest, std::size_t count) const;
+
+        // distanceAtMeasure() for many positions at once (one linear pass when y values are sorted; e.g. visible notes of a lane)
+        void distancesAtMeasures(const Measure * ys, double * dest, std::size_t count) const;
+
+        Cursor cursor() const
+        {
+            return Cursor(*this);
+        }
+
+        double referenceTempo() const
+        {
+            return m_referenceTempo;
+        }
+
+        const std::vector<Measure> & breakpointYs() const
+        {
+            return m_breakpointYs;
+        }
+
+        const std::vector<Ms> & breakpointMs() const
+        {
+            return m_breakpointMs;
+        }
+
+        MemoryUsage memoryUsage() const
+        {
+            return vectorMemoryUsage(m_breakpointYs) + vectorMemoryUsage(m_breakpointMs) + vectorMemoryUsage(m_distances) + vectorMemoryUsage(m_slopes);
+        }
+    };
+
+}
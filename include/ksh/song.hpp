@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+#include "ksh/playable_chart.hpp"
+#include "ksh/frozen_chart.hpp"
+
+namespace ksh
+{
+
+    // Charts of all difficulties of a song, loaded together
+    //
+    // The difficulties are parsed in parallel, and charts with equivalent beat maps share one BeatMap.
+    // Each chart keeps its own meta data; metaData() only lists the values common to all difficulties.
+    template <class Layout>
+    class BasicSong
+    {
+    public:
+        using ChartType = BasicPlayableChart<Layout>;
+        using FrozenChartType = BasicFrozenChart<Layout>;
+
+    private:
+        std::vector<FrozenChartType> m_charts; // Sorted by difficulty (charts with the same difficulty keep the filename order)
+        std::unordered_map<std::string_view, std::string_view> m_metaData; // Views into the meta data of the first chart
+        std::vector<std::string> m_failedFilenames;
+        std::size_t m_beatMapCount = 0;
+
+    public:
+        BasicSong() = default;
+
+        // Load all .ksh files directly under the directory on threadCount threads (0 = all cores)
+        explicit BasicSong(std::string_view directoryPath, std::size_t threadCount = 0);
+
+        // Load the given chart files on threadCount threads (0 = all cores)
+        explicit BasicSong(const std::vector<std::string> & chartFilenames, std::size_t threadCount = 0);
+
+        const std::vector<FrozenChartType> & charts() const
+        {
+            return m_charts;
+        }
+
+        // nullptr if the song has no chart of the difficulty
+        const ChartType * chartOfDifficulty(int difficultyIdx) const;
+
+        // Meta data values that are the same in all difficulties ("title=", "artist=", "jacket=" etc.)
+        // (views into the charts, valid while the charts are alive)
+        const std::unordered_map<std::string_view, std::string_view> & metaData() const
+        {
+            return m_metaData;
+        }
+
+        // Files that could not be opened or have an Error diagnostic (not included in charts(), metaData() or beatMapCount())
+        const std::vector<std::string> & failedFilenames() const
+        {
+            return m_failedFilenames;
+        }
+
+        // Number of distinct beat maps after deduplication
+        std::size_t beatMapCount() const
+        {
+            return m_beatMapCount;
+        }
+
+        bool empty() const
+        {
+            return m_charts.empty();
+        }
+    };
+
+    using Song = BasicSong<DefaultLaneLayout>;
+
+    extern template class BasicSong<DefaultLaneLayout>;
+    extern template class BasicSong<SixBTLaneLayout>;
+
+}
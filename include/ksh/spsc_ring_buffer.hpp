@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace ksh
+{
+
+    // Wait-free single-producer single-consumer ring buffer with fixed capacity (no allocation)
+    // tryPush() must be called only from one thread, and front()/pop() only from one other thread
+    template <typename T, std::size_t Capacity>
+    class SPSCRingBuffer
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+    private:
+        static constexpr std::size_t CACHE_LINE_SIZE = 64;
+        static constexpr std::size_t INDEX_MASK = Capacity - 1;
+
+        // Indices increase monotonically (wrap-around of std::size_t is harmless because Capacity is a power of two)
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_head{ 0 }; // Written by the consumer
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail{ 0 }; // Written by the producer
+        alignas(CACHE_LINE_SIZE) std::array<T, Capacity> m_items;
+
+    public:
+        SPSCRingBuffer() = default;
+
+        SPSCRingBuffer(const SPSCRingBuffer &) = delete;
+
+        SPSCRingBuffer & operator=(const SPSCRingBuffer &) = delete;
+
+        // Producer: returns false if full
+        bool tryPush(const T & item)
+        {
+            const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+            {
+                return false;
+            }
+            m_items[tail & INDEX_MASK] = item;
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer: returns nullptr if empty (valid until pop())
+        const T * front() const
+        {
+            const std::size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+            return &m_items[head & INDEX_MASK];
+        }
+
+        // Consumer: must be called only if front() is not nullptr
+        void pop()
+        {
+            m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Consumer: returns false if empty
+        bool tryPop(T & item)
+        {
+            const T * p = front();
+            if (p == nullptr)
+            {
+                return false;
+            }
+            item = *p;
+            pop();
+            return true;
+        }
+
+        // Approximate if called while the other thread is running
+        std::size_t size() const
+        {
+            return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+        }
+
+        static constexpr std::size_t capacity()
+        {
+            return Capacity;
+        }
+    };
+
+}
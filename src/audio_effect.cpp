@@ -0,0 +1,414 @@
+#include "ksh/audio_effect.hpp"
+
+#include <cstdlib>
+#include <limits>
+
+namespace ksh
+{
+
+    namespace
+    {
+        // Parse a number without exceptions (returns false if str does not start with a number)
+        bool parseNumber(std::string_view str, double & value, std::string_view & suffix)
+        {
+            const std::string s(str);
+            const char * begin = s.c_str();
+            char * end;
+            value = std::strtod(begin, &end);
+            if (end == begin)
+            {
+                return false;
+            }
+            suffix = str.substr(static_cast<std::size_t>(end - begin));
+            return true;
+        }
+
+        // Parse a parameter value of a user-defined audio effect
+        // (e.g. "1/8", "60%", "-6dB", "10ms", "3kHz", "on", "500Hz-20000Hz")
+        bool parseParamValue(std::string_view str, double & value)
+        {
+            if (str == "on")
+            {
+                value = 1.0;
+                return true;
+            }
+            if (str == "off")
+            {
+                value = 0.0;
+                return true;
+            }
+
+            // Use the second value of a range ("-" after the first character is not a sign)
+            const std::size_t rangeIdx = str.find('-', 1);
+            if (rangeIdx != std::string_view::npos)
+            {
+                str = str.substr(rangeIdx + 1);
+            }
+
+            std::string_view suffix;
+            if (!parseNumber(str, value, suffix))
+            {
+                return false;
+            }
+
+            if (!suffix.empty() && suffix[0] == '/')
+            {
+                double denominator;
+                std::string_view denominatorSuffix;
+                if (!parseNumber(suffix.substr(1), denominator, denominatorSuffix) || denominator == 0.0)
+                {
+                    return false;
+                }
+                value /= denominator;
+            }
+            else if (suffix == "%")
+            {
+                value /= 100;
+            }
+            else if (suffix == "kHz")
+            {
+                value *= 1000;
+            }
+            return true;
+        }
+
+        double builtInParam(const std::vector<std::string_view> & params, std::size_t idx, double defaultValue)
+        {
+            if (idx >= params.size())
+            {
+                return defaultValue;
+            }
+            double value;
+            std::string_view suffix;
+            return parseNumber(params[idx], value, suffix) ? value : defaultValue;
+        }
+
+        // Parameter used as a divisor (e.g. "8" in "Retrigger;8"; zero or negative values fall back to the default)
+        double builtInDivisorParam(const std::vector<std::string_view> & params, std::size_t idx, double defaultValue)
+        {
+            const double value = builtInParam(params, idx, defaultValue);
+            return (value > 0.0) ? value : defaultValue;
+        }
+
+        std::vector<std::string_view> split(std::string_view str, char separator)
+        {
+            std::vector<std::string_view> tokens;
+            std::size_t pos = 0;
+            while (true)
+            {
+                const std::size_t separatorIdx = str.find(separator, pos);
+                tokens.push_back(str.substr(pos, separatorIdx - pos));
+                if (separatorIdx == std::string_view::npos)
+                {
+                    break;
+                }
+                pos = separatorIdx + 1;
+            }
+            return tokens;
+        }
+
+        AudioEffectParams defaultParams(std::string_view type)
+        {
+            if (type == "Retrigger")
+            {
+                return RetriggerParams();
+            }
+            else if (type == "Gate")
+            {
+                return GateParams();
+            }
+            else if (type == "Flanger")
+            {
+                return FlangerParams();
+            }
+            else if (type == "PitchShift")
+            {
+                return PitchShiftParams();
+            }
+            else if (type == "BitCrusher")
+            {
+                return BitCrusherParams();
+            }
+            else if (type == "Phaser")
+            {
+                return PhaserParams();
+            }
+            else if (type == "Wobble")
+            {
+                return WobbleParams();
+            }
+            else if (type == "TapeStop")
+            {
+                return TapeStopParams();
+            }
+            else if (type == "Echo")
+            {
+                return EchoParams();
+            }
+            else if (type == "SideChain")
+            {
+                return SideChainParams();
+            }
+            else if (type == "LowPassFilter")
+            {
+                return FilterParams{ FilterParams::Type::LowPass };
+            }
+            else if (type == "HighPassFilter")
+            {
+                return FilterParams{ FilterParams::Type::HighPass };
+            }
+            else if (type == "PeakingFilter")
+            {
+                return FilterParams{ FilterParams::Type::Peaking };
+            }
+            else
+            {
+                return std::monostate();
+            }
+        }
+
+        // Apply a parameter of a user-defined audio effect (unknown parameters are ignored)
+        struct ParamSetter
+        {
+            std::string_view key;
+            double value;
+
+            void operator()(std::monostate &) const
+            {
+            }
+
+            void operator()(RetriggerParams & params) const
+            {
+                if (key == "waveLength") params.waveLength = value;
+                else if (key == "updatePeriod") params.updatePeriod = value;
+                else if (key == "rate") params.rate = value;
+                else if (key == "mix") params.mix = value;
+            }
+
+            void operator()(GateParams & params) const
+            {
+                if (key == "waveLength") params.waveLength = value;
+                else if (key == "rate") params.rate = value;
+                else if (key == "mix") params.mix = value;
+            }
+
+            void operator()(FlangerParams & params) const
+            {
+                if (key == "period") params.periodMeasure = value;
+                else if (key == "delay") params.delaySamples = value;
+                else if (key == "depth") params.depthSamples = value;
+                else if (key == "feedback") params.feedback = value;
+                else if (key == "mix") params.mix = value;
+            }
+
+            void operator()(PitchShiftParams & params) const
+            {
+                if (key == "pitch") params.pitch = value;
+                else if (key == "mix") params.mix = value;
+            }
+
+            void operator()(BitCrusherParams & params) const
+            {
+                if (key == "reduction") params.reductionSamples = value;
+                else if (key == "mix") params.mix = value;
+            }
+
+            void operator()(PhaserParams & params) const
+            {
+                if (key == "period") params.periodMeasure = value;
+                else if (key == "feedback") params.feedback = value;
+                else if (key == "stereoWidth") params.stereoWidth = value;
+                else if (key == "mix") params.mix = value;
+            }
+
+            void operator()(WobbleParams & params) const
+            {
+                if (key == "waveLength") params.waveLength = value;
+                else if (key == "loFreq") params.loFreqHz = value;
+                else if (key == "hiFreq") params.hiFreqHz = value;
+                else if (key == "Q") params.q = value;
+                else if (key == "mix") params.mix = value;
+            }
+
+            void operator()(TapeStopParams & params) const
+            {
+                if (key == "speed") params.speed = value;
+                else if (key == "mix") params.mix = value;
+            }
+
+            void operator()(EchoParams & params) const
+            {
+                if (key == "waveLength") params.waveLength = value;
+                else if (key == "feedbackLevel") params.feedback = value;
+                else if (key == "mix") params.mix = value;
+            }
+
+            void operator()(SideChainParams & params) const
+            {
+                if (key == "period") params.periodMeasure = value;
+                else if (key == "holdTime") params.holdTimeMeasure = value;
+                else if (key == "attackTime") params.attackTimeMs = value;
+                else if (key == "releaseTime") params.releaseTimeMeasure = value;
+                else if (key == "ratio") params.ratio = value;
+            }
+
+            void operator()(FilterParams & params) const
+            {
+                if (key == "freq") params.freqHz = value;
+                else if (key == "Q" || key == "v") params.q = value;
+                else if (key == "gain") params.gainDb = value;
+                else if (key == "mix") params.mix = value;
+            }
+        };
+    }
+
+    AudioEffectParams parseBuiltInAudioEffect(std::string_view audioEffectStr, std::string_view paramStr)
+    {
+        std::vector<std::string_view> params = split(audioEffectStr, ';');
+        const std::string_view type = params.front();
+        params.erase(params.begin());
+        if (params.empty() && !paramStr.empty())
+        {
+            params.push_back(paramStr);
+        }
+
+        AudioEffectParams effect = defaultParams(type);
+        if (auto p = std::get_if<RetriggerParams>(&effect))
+        {
+            p->waveLength = 1.0 / builtInDivisorParam(params, 0, 8);
+        }
+        else if (auto p = std::get_if<GateParams>(&effect))
+        {
+            p->waveLength = 1.0 / builtInDivisorParam(params, 0, 4);
+        }
+        else if (auto p = std::get_if<WobbleParams>(&effect))
+        {
+            p->waveLength = 1.0 / builtInDivisorParam(params, 0, 12);
+        }
+        else if (auto p = std::get_if<EchoParams>(&effect))
+        {
+            p->waveLength = 1.0 / builtInDivisorParam(params, 0, 4);
+            p->feedback = builtInParam(params, 1, 60) / 100;
+        }
+        else if (auto p = std::get_if<PitchShiftParams>(&effect))
+        {
+            p->pitch = builtInParam(params, 0, 12);
+        }
+        else if (auto p = std::get_if<BitCrusherParams>(&effect))
+        {
+            p->reductionSamples = builtInParam(params, 0, 5);
+        }
+        else if (auto p = std::get_if<TapeStopParams>(&effect))
+        {
+            p->speed = builtInParam(params, 0, 50) / 100;
+        }
+        return effect;
+    }
+
+    AudioEffectParams parseAudioEffectDefinition(std::string_view definitionStr)
+    {
+        const std::vector<std::string_view> params = split(definitionStr, ';');
+
+        // Find the type first (it may not be the first parameter)
+        AudioEffectParams effect;
+        for (std::string_view param : params)
+        {
+            if (param.substr(0, 5) == "type=")
+            {
+                effect = defaultParams(param.substr(5));
+                break;
+            }
+        }
+
+        for (std::string_view param : params)
+        {
+            const std::size_t equalIdx = param.find('=');
+            if (equalIdx == std::string_view::npos)
+            {
+                continue;
+            }
+            double value;
+            if (parseParamValue(param.substr(equalIdx + 1), value))
+            {
+                std::visit(ParamSetter{ param.substr(0, equalIdx), value }, effect);
+            }
+        }
+        return effect;
+    }
+
+    AudioEffectTable::AudioEffectTable()
+        : m_effects{ std::monostate() }
+    {
+    }
+
+    bool AudioEffectTable::addDefinitionLine(std::string_view line)
+    {
+        // "#define_fx <name> <params>" or "#define_filter <name> <params>"
+        const std::size_t nameIdx = line.find(' ');
+        if (nameIdx == std::string_view::npos)
+        {
+            return false;
+        }
+        const std::string_view directive = line.substr(0, nameIdx);
+        if (directive != "#define_fx" && directive != "#define_filter")
+        {
+            return false;
+        }
+
+        const std::size_t paramsIdx = line.find(' ', nameIdx + 1);
+        if (paramsIdx == std::string_view::npos)
+        {
+            return false;
+        }
+        m_definitions[std::string(line.substr(nameIdx + 1, paramsIdx - nameIdx - 1))] = parseAudioEffectDefinition(line.substr(paramsIdx + 1));
+        return true;
+    }
+
+    AudioEffectTable::Index AudioEffectTable::resolve(const std::string & audioEffectStr, const std::string & paramStr)
+    {
+        if (audioEffectStr.empty())
+        {
+            return NONE;
+        }
+
+        const std::string key = audioEffectStr + ';' + paramStr;
+        const auto indexItr = m_indices.find(key);
+        if (indexItr != m_indices.end())
+        {
+            return indexItr->second;
+        }
+
+        const auto definitionItr = m_definitions.find(audioEffectStr);
+        AudioEffectParams effect = (definitionItr != m_definitions.end()) ? definitionItr->second : parseBuiltInAudioEffect(audioEffectStr, paramStr);
+
+        Index idx = NONE;
+        if (!std::holds_alternative<std::monostate>(effect))
+        {
+            if (m_effects.size() > std::numeric_limits<Index>::max())
+            {
+                // Full (not cached in m_indices)
+                m_overflowed = true;
+                return NONE;
+            }
+            idx = static_cast<Index>(m_effects.size());
+            m_effects.push_back(effect);
+        }
+        m_indices.emplace(key, idx);
+        return idx;
+    }
+
+    MemoryUsage AudioEffectTable::memoryUsage() const
+    {
+        MemoryUsage usage = vectorMemoryUsage(m_effects) + hashMemoryUsage(m_definitions) + hashMemoryUsage(m_indices);
+        for (const auto & [ name, effect ] : m_definitions)
+        {
+            usage += stringMemoryUsage(name);
+        }
+        for (const auto & [ key, idx ] : m_indices)
+        {
+            usage += stringMemoryUsage(key);
+        }
+        return usage;
+    }
+
+}
@@ -0,0 +1,75 @@
+#include "ksh/audio_effect_timeline.hpp"
+
+#include <algorithm>
+
+namespace ksh
+{
+
+    AudioEffectTimeline::AudioEffectTimeline(const Lane<FXNote> & lane, AudioEffectTable & table, const BeatMap & beatMap)
+    {
+        m_intervals.reserve(lane.size());
+        for (const auto & [ y, note ] : lane)
+        {
+            if (note.length == 0)
+            {
+                continue;
+            }
+
+            const AudioEffectTable::Index effectIdx = table.resolve(note.audioEffectStr, note.audioEffectParamStr);
+            if (effectIdx == AudioEffectTable::NONE)
+            {
+                continue;
+            }
+
+            const Ms startMs = beatMap.measureToMs(y);
+            const Ms endMs = beatMap.measureToMs(y + note.length);
+
+            // Notes in the same lane do not overlap, but clamp just in case
+            if (!m_intervals.empty() && m_intervals.back().endMs > startMs)
+            {
+                m_intervals.back().endMs = startMs;
+            }
+            m_intervals.push_back(Interval{ startMs, endMs, effectIdx });
+        }
+    }
+
+    std::size_t AudioEffectTimeline::intervalIdxAt(Ms ms) const
+    {
+        const auto itr = std::upper_bound(m_intervals.begin(), m_intervals.end(), ms, [](Ms value, const Interval & interval) { return value < interval.endMs; });
+        return static_cast<std::size_t>(std::distance(m_intervals.begin(), itr));
+    }
+
+    AudioEffectTable::Index AudioEffectTimeline::effectIdxAt(Ms ms) const
+    {
+        const std::size_t idx = intervalIdxAt(ms);
+        if (idx < m_intervals.size() && m_intervals[idx].startMs <= ms)
+        {
+            return m_intervals[idx].effectIdx;
+        }
+        return AudioEffectTable::NONE;
+    }
+
+    AudioEffectTable::Index AudioEffectTimeline::Cursor::effectIdxAt(Ms ms)
+    {
+        const std::vector<Interval> & intervals = m_timeline->m_intervals;
+        if (m_idx > 0 && ms < intervals[m_idx - 1].endMs)
+        {
+            // Time went backward
+            m_idx = m_timeline->intervalIdxAt(ms);
+        }
+        else
+        {
+            while (m_idx < intervals.size() && intervals[m_idx].endMs <= ms)
+            {
+                ++m_idx;
+            }
+        }
+
+        if (m_idx < intervals.size() && intervals[m_idx].startMs <= ms)
+        {
+            return intervals[m_idx].effectIdx;
+        }
+        return AudioEffectTable::NONE;
+    }
+
+}
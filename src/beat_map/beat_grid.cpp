@@ -0,0 +1,49 @@
+#include "ksh/beat_map/beat_grid.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+BeatGrid::BeatGrid(const BeatMap & beatMap, int measureCount)
+{
+    if (measureCount <= 0)
+    {
+        return;
+    }
+
+    const auto & timeSigChanges = beatMap.timeSigChanges();
+    for (auto itr = timeSigChanges.begin(); itr != timeSigChanges.end() && itr->first < measureCount; ++itr)
+    {
+        // Measures until the next time signature change
+        const int endMeasureIdx = (std::next(itr) != timeSigChanges.end()) ? std::min(std::next(itr)->first, measureCount) : measureCount;
+        const TimeSig & timeSig = itr->second;
+        const Measure measureLength = timeSig.measure();
+        const Measure startY = beatMap.measureCountToMeasure(itr->first);
+        for (int measureIdx = itr->first; measureIdx < endMeasureIdx; ++measureIdx)
+        {
+            const Measure barY = startY + measureLength * (measureIdx - itr->first);
+            for (uint32_t beatIdx = 0; beatIdx < timeSig.numerator; ++beatIdx)
+            {
+                // Beat positions are rounded down if UNIT_MEASURE is not divisible by the denominator
+                const Measure y = barY + UNIT_MEASURE * static_cast<Measure>(beatIdx) / static_cast<Measure>(timeSig.denominator);
+                m_lines.push_back(Line{ y, beatMap.measureToMs(y), measureIdx, static_cast<int>(beatIdx) });
+            }
+        }
+    }
+
+    const Measure endY = beatMap.measureCountToMeasure(measureCount);
+    m_lines.push_back(Line{ endY, beatMap.measureToMs(endY), measureCount, 0 });
+}
+
+BeatGrid::LineRange BeatGrid::linesInMeasureRange(Measure yBegin, Measure yEnd) const
+{
+    const auto first = std::lower_bound(m_lines.begin(), m_lines.end(), yBegin, [](const Line & line, Measure y) { return line.y < y; });
+    const auto last = std::lower_bound(first, m_lines.end(), yEnd, [](const Line & line, Measure y) { return line.y < y; });
+    return LineRange(m_lines.data() + std::distance(m_lines.begin(), first), m_lines.data() + std::distance(m_lines.begin(), last));
+}
+
+BeatGrid::LineRange BeatGrid::linesInMsRange(Ms msBegin, Ms msEnd) const
+{
+    const auto first = std::lower_bound(m_lines.begin(), m_lines.end(), msBegin, [](const Line & line, Ms ms) { return line.ms < ms; });
+    const auto last = std::lower_bound(first, m_lines.end(), msEnd, [](const Line & line, Ms ms) { return line.ms < ms; });
+    return LineRange(m_lines.data() + std::distance(m_lines.begin(), first), m_lines.data() + std::distance(m_lines.begin(), last));
+}
@@ -1,9 +1,30 @@
 #include "ksh/beat_map/beat_map.hpp"
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 
-BeatMap::BeatMap(const std::map<Measure, double>& tempoChanges, const std::map<int, TimeSig>& timeSigChanges)
-    : m_tempoChanges(tempoChanges)
-    , m_timeSigChanges(timeSigChanges)
+namespace
+{
+    // Microseconds of one measure unit at 1/1000 BPM (4 beats * 60 s * 10^6 us * 1000 / UNIT_MEASURE)
+    constexpr int64_t US_PER_MEASURE_UNIT_AT_MILLI_BPM = 4LL * 60 * 1000000 * 1000 / UNIT_MEASURE;
+    static_assert(4LL * 60 * 1000000 * 1000 % UNIT_MEASURE == 0, "US_PER_MEASURE_UNIT_AT_MILLI_BPM must be exact");
+
+    // Division rounded toward negative infinity (b > 0)
+    int64_t floorDiv(int64_t a, int64_t b)
+    {
+        const int64_t q = a / b;
+        return (a % b < 0) ? q - 1 : q;
+    }
+}
+
+BeatMap::BeatMap(const std::map<Measure, double>& tempoChanges, const std::map<int, TimeSig>& timeSigChanges, std::pmr::memory_resource* resource)
+    : m_tempoChanges(tempoChanges.begin(), tempoChanges.end(), resource)
+    , m_timeSigChanges(timeSigChanges.begin(), timeSigChanges.end(), resource)
+    , m_tempoChangeMsCache(resource)
+    , m_tempoChangeMeasureCache(resource)
+    , m_timeSigChangeMeasureCache(resource)
+    , m_timeSigChangeMeasureCountCache(resource)
+    , m_tempoSegments(resource)
 {
     // There must be at least one tempo change
     assert(m_tempoChanges.size() > 0);
@@ -36,6 +57,22 @@ BeatMap::BeatMap(const std::map<Measure, double>& tempoChanges, const std::map<i
         }
     }
 
+    // Calculate us for each tempo change (the time of a segment is rounded once at its end, so the error does not depend on the query)
+    {
+        m_tempoSegments.reserve(m_tempoChanges.size());
+        Us us = 0;
+        for (const auto & [ y, tempo ] : m_tempoChanges)
+        {
+            const int64_t milliTempo = std::max(static_cast<int64_t>(std::llround(tempo * 1000)), int64_t{ 1 });
+            if (!m_tempoSegments.empty())
+            {
+                const TempoSegment & prev = m_tempoSegments.back();
+                us = prev.us + floorDiv((y - prev.y) * US_PER_MEASURE_UNIT_AT_MILLI_BPM, prev.milliTempo);
+            }
+            m_tempoSegments.push_back(TempoSegment{ y, us, milliTempo });
+        }
+    }
+
     // Calculate measure count for each time signature change
     {
         Measure measure = 0;
@@ -72,6 +109,52 @@ Measure BeatMap::msToMeasure(Ms ms) const
     return measure;
 }
 
+std::size_t BeatMap::tempoSegmentIdxAtMeasure(Measure measure) const
+{
+    const auto itr = std::upper_bound(m_tempoSegments.begin(), m_tempoSegments.end(), measure, [](Measure value, const TempoSegment & segment) { return value < segment.y; });
+    return (itr == m_tempoSegments.begin()) ? 0 : static_cast<std::size_t>(std::distance(m_tempoSegments.begin(), itr)) - 1;
+}
+
+Us BeatMap::measureToUs(Measure measure) const
+{
+    const TempoSegment & segment = m_tempoSegments[tempoSegmentIdxAtMeasure(measure)];
+    return segment.us + floorDiv((measure - segment.y) * US_PER_MEASURE_UNIT_AT_MILLI_BPM, segment.milliTempo);
+}
+
+Measure BeatMap::usToMeasure(Us us) const
+{
+    // Fetch the nearest tempo change
+    auto itr = std::upper_bound(m_tempoSegments.begin(), m_tempoSegments.end(), us, [](Us value, const TempoSegment & segment) { return value < segment.us; });
+    if (itr != m_tempoSegments.begin()) --itr;
+
+    // Largest measure whose measureToUs() does not exceed us (so that usToMeasure(measureToUs(y)) == y)
+    return itr->y + floorDiv((us - itr->us + 1) * itr->milliTempo - 1, US_PER_MEASURE_UNIT_AT_MILLI_BPM);
+}
+
+void BeatMap::measuresToUs(const Measure * measures, Us * dest, std::size_t count) const
+{
+    std::size_t segmentIdx = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const Measure measure = measures[i];
+        if (measure < m_tempoSegments[segmentIdx].y)
+        {
+            // Not sorted
+            segmentIdx = tempoSegmentIdxAtMeasure(measure);
+        }
+        else
+        {
+            while (segmentIdx + 1 < m_tempoSegments.size() && m_tempoSegments[segmentIdx + 1].y <= measure)
+            {
+                ++segmentIdx;
+            }
+        }
+
+        const TempoSegment & segment = m_tempoSegments[segmentIdx];
+        dest[i] = segment.us + floorDiv((measure - segment.y) * US_PER_MEASURE_UNIT_AT_MILLI_BPM, segment.milliTempo);
+    }
+}
+
 int BeatMap::measureToMeasureCount(Measure measure) const
 {
     // Fetch the nearest time signature change
@@ -147,3 +230,21 @@ TimeSig BeatMap::timeSig(Measure measure) const
 
     return m_timeSigChanges.at(itr->second);
 }
+
+ksh::MemoryUsage BeatMap::memoryUsage() const
+{
+    return ksh::treeMemoryUsage(m_tempoChanges)
+        + ksh::treeMemoryUsage(m_timeSigChanges)
+        + ksh::treeMemoryUsage(m_tempoChangeMsCache)
+        + ksh::treeMemoryUsage(m_tempoChangeMeasureCache)
+        + ksh::treeMemoryUsage(m_timeSigChangeMeasureCache)
+        + ksh::treeMemoryUsage(m_timeSigChangeMeasureCountCache)
+        + ksh::vectorMemoryUsage(m_tempoSegments);
+}
+
+bool BeatMap::isEquivalentTo(const BeatMap & other) const
+{
+    return m_tempoChanges == other.m_tempoChanges
+        && std::equal(m_timeSigChanges.begin(), m_timeSigChanges.end(), other.m_timeSigChanges.begin(), other.m_timeSigChanges.end(),
+            [](const auto & a, const auto & b) { return a.first == b.first && a.second.numerator == b.second.numerator && a.second.denominator == b.second.denominator; });
+}
@@ -0,0 +1,189 @@
+#include "ksh/camera_timeline.hpp"
+
+#include <algorithm>
+
+namespace ksh
+{
+
+    namespace
+    {
+        // Value just after the measure (the second value of the plot if a plot is there)
+        double rightValueAt(const LineGraph & graph, Measure measure)
+        {
+            return graph.count(measure) ? graph.at(measure).second : graph.valueAt(measure);
+        }
+
+        // Value just before the measure (the first value of the plot if a plot is there)
+        double leftValueAt(const LineGraph & graph, Measure measure)
+        {
+            return graph.count(measure) ? graph.at(measure).first : graph.valueAt(measure);
+        }
+    }
+
+    TiltMode kshTiltStrToTiltMode(std::string_view str)
+    {
+        if (str == "bigger")
+        {
+            return TiltMode::Bigger;
+        }
+        else if (str == "biggest")
+        {
+            return TiltMode::Biggest;
+        }
+        else if (str == "keep_normal")
+        {
+            return TiltMode::KeepNormal;
+        }
+        else if (str == "keep_bigger")
+        {
+            return TiltMode::KeepBigger;
+        }
+        else if (str == "keep_biggest")
+        {
+            return TiltMode::KeepBiggest;
+        }
+        else if (str == "zero")
+        {
+            return TiltMode::Zero;
+        }
+        else if (str == "manual")
+        {
+            return TiltMode::Manual;
+        }
+        else
+        {
+            return TiltMode::Normal;
+        }
+    }
+
+    CameraTimeline::CameraTimeline(
+        const std::array<const LineGraph *, COLUMN_COUNT> & graphs,
+        const std::pmr::map<Measure, std::pmr::string> & tiltOptions,
+        const BeatMap & beatMap)
+    {
+        // Merge all breakpoints
+        std::vector<Measure> breakpoints;
+        for (const LineGraph * graph : graphs)
+        {
+            for (const auto & plot : *graph)
+            {
+                breakpoints.push_back(plot.first);
+            }
+        }
+        for (const auto & option : tiltOptions)
+        {
+            breakpoints.push_back(option.first);
+        }
+        for (const auto & tempoChange : beatMap.tempoChanges())
+        {
+            breakpoints.push_back(tempoChange.first);
+        }
+        std::sort(breakpoints.begin(), breakpoints.end());
+        breakpoints.erase(std::unique(breakpoints.begin(), breakpoints.end()), breakpoints.end());
+
+        const std::size_t breakpointCount = breakpoints.size();
+        m_breakpointMs.reserve(breakpointCount);
+        for (Measure measure : breakpoints)
+        {
+            m_breakpointMs.push_back(beatMap.measureToMs(measure));
+        }
+
+        for (std::size_t column = 0; column < COLUMN_COUNT; ++column)
+        {
+            const LineGraph & graph = *graphs[column];
+            std::vector<double> & startValues = m_startValues[column];
+            std::vector<double> & endValues = m_endValues[column];
+            startValues.reserve(breakpointCount);
+            endValues.reserve(breakpointCount);
+            for (std::size_t i = 0; i < breakpointCount; ++i)
+            {
+                startValues.push_back(rightValueAt(graph, breakpoints[i]));
+                endValues.push_back((i + 1 < breakpointCount) ? leftValueAt(graph, breakpoints[i + 1]) : startValues.back());
+            }
+        }
+
+        m_tiltModes.reserve(breakpointCount);
+        auto tiltItr = tiltOptions.begin();
+        TiltMode tiltMode = TiltMode::Normal;
+        for (Measure measure : breakpoints)
+        {
+            while (tiltItr != tiltOptions.end() && tiltItr->first <= measure)
+            {
+                tiltMode = kshTiltStrToTiltMode(tiltItr->second);
+                ++tiltItr;
+            }
+            m_tiltModes.push_back(tiltMode);
+        }
+    }
+
+    std::size_t CameraTimeline::intervalIdxAt(Ms ms) const
+    {
+        const auto itr = std::upper_bound(m_breakpointMs.begin(), m_breakpointMs.end(), ms);
+        return (itr == m_breakpointMs.begin()) ? 0 : static_cast<std::size_t>(std::distance(m_breakpointMs.begin(), itr)) - 1;
+    }
+
+    CameraState CameraTimeline::stateAt(std::size_t idx, Ms ms) const
+    {
+        CameraState state;
+        if (m_breakpointMs.empty())
+        {
+            return state;
+        }
+
+        double rate = 0.0;
+        if (idx + 1 < m_breakpointMs.size() && ms > m_breakpointMs[idx])
+        {
+            rate = (ms - m_breakpointMs[idx]) / (m_breakpointMs[idx + 1] - m_breakpointMs[idx]);
+        }
+
+        std::array<double, COLUMN_COUNT> values;
+        for (std::size_t column = 0; column < COLUMN_COUNT; ++column)
+        {
+            const double startValue = m_startValues[column][idx];
+            values[column] = startValue + (m_endValues[column][idx] - startValue) * rate;
+        }
+        state.zoomTop = values[COLUMN_ZOOM_TOP];
+        state.zoomBottom = values[COLUMN_ZOOM_BOTTOM];
+        state.zoomSide = values[COLUMN_ZOOM_SIDE];
+        state.centerSplit = values[COLUMN_CENTER_SPLIT];
+        state.manualTilt = values[COLUMN_MANUAL_TILT];
+        state.tiltMode = m_tiltModes[idx];
+
+        return state;
+    }
+
+    CameraState CameraTimeline::stateAt(Ms ms) const
+    {
+        return stateAt(intervalIdxAt(ms), ms);
+    }
+
+    MemoryUsage CameraTimeline::memoryUsage() const
+    {
+        MemoryUsage usage = vectorMemoryUsage(m_breakpointMs) + vectorMemoryUsage(m_tiltModes);
+        for (std::size_t column = 0; column < COLUMN_COUNT; ++column)
+        {
+            usage += vectorMemoryUsage(m_startValues[column]);
+            usage += vectorMemoryUsage(m_endValues[column]);
+        }
+        return usage;
+    }
+
+    CameraState CameraTimeline::Cursor::stateAt(Ms ms)
+    {
+        const std::vector<Ms> & breakpointMs = m_timeline->m_breakpointMs;
+        if (m_idx < breakpointMs.size() && ms < breakpointMs[m_idx])
+        {
+            // Time went backward
+            m_idx = m_timeline->intervalIdxAt(ms);
+        }
+        else
+        {
+            while (m_idx + 1 < breakpointMs.size() && breakpointMs[m_idx + 1] <= ms)
+            {
+                ++m_idx;
+            }
+        }
+        return m_timeline->stateAt(m_idx, ms);
+    }
+
+}
@@ -1,17 +1,33 @@
 #include "ksh/chart.hpp"
 
 #include <sstream>
-#include <cassert>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include "ksh/encoding/shift_jis.hpp"
 
 namespace ksh
 {
 
-    Chart::Chart(std::string_view filename, bool keepFileStreamOpen)
+    Chart::Chart(std::string_view filename, bool keepFileStreamOpen, std::pmr::memory_resource * resource)
         : m_filename(filename)
         , m_fileDirectoryPath(filename.substr(0, filename.find_last_of("/\\")))
         , m_ifs(std::make_unique<std::ifstream>())
+        , m_bodyPos(-1)
+        , m_bodyLineNumber(0)
+        , m_fileOpenFailed(false)
+        , m_difficultyIdx(0)
+        , metaData(resource)
     {
-        m_ifs->open(filename.data(), std::ifstream::in); // TODO: Error handling
+        m_ifs->open(filename.data(), std::ifstream::in);
+        if (!m_ifs->is_open())
+        {
+            m_isUTF8 = false;
+            m_fileOpenFailed = true;
+            addDiagnostic(DiagnosticSeverity::Error, 0, "Failed to open the file");
+            return;
+        }
 
         // Eliminate UTF-8 BOM
         std::string firstLine;
@@ -28,9 +44,12 @@ namespace ksh
         }
 
         std::string line;
+        std::size_t lineNumber = 0;
         bool barLineExists = false;
         while (std::getline(*m_ifs, line, '\n'))
         {
+            ++lineNumber;
+
             // Eliminate CR
             if (!line.empty() && *line.crbegin() == '\r')
             {
@@ -41,6 +60,8 @@ namespace ksh
             {
                 // Chart meta data is before first bar line ("--")
                 barLineExists = true;
+                m_bodyPos = m_ifs->tellg();
+                m_bodyLineNumber = lineNumber + 1;
                 break;
             }
 
@@ -50,6 +71,12 @@ namespace ksh
                 continue;
             }
 
+            // Convert Shift_JIS to UTF-8
+            if (!m_isUTF8 && !isASCII(line))
+            {
+                line = shiftJISToUTF8(line);
+            }
+
             auto equalPos = line.find_first_of('=');
             if (equalPos == std::string::npos)
             {
@@ -57,15 +84,14 @@ namespace ksh
                 continue;
             }
 
-            std::string key = line.substr(0, equalPos);
-            std::string value = line.substr(equalPos + 1);
-            metaData[key] = value;
+            const std::string_view lineView = line;
+            metaData.insert_or_assign(std::pmr::string(lineView.substr(0, equalPos), resource), std::pmr::string(lineView.substr(equalPos + 1), resource));
         }
 
         // Determine difficulty index
         if (metaData.count("difficulty"))
         {
-            const std::string & d = metaData.at("difficulty");
+            const std::pmr::string & d = metaData.at("difficulty");
             if (d == "light")
             {
                 m_difficultyIdx = 0;
@@ -82,10 +108,21 @@ namespace ksh
             {
                 m_difficultyIdx = 3;
             }
+            else
+            {
+                addDiagnostic(DiagnosticSeverity::Warning, 0, "Unknown difficulty \"" + std::string(d) + "\"");
+            }
+        }
+        else
+        {
+            addDiagnostic(DiagnosticSeverity::Warning, 0, "Missing difficulty");
         }
 
         // .ksh files should have at least one bar line ("--")
-        assert(barLineExists);
+        if (!barLineExists)
+        {
+            addDiagnostic(DiagnosticSeverity::Error, 0, "No bar line (\"--\")");
+        }
 
         if (!keepFileStreamOpen)
         {
@@ -93,7 +130,7 @@ namespace ksh
         }
     }
 
-    Chart::Chart(std::string_view filename) : Chart(filename, false)
+    Chart::Chart(std::string_view filename, std::pmr::memory_resource * resource) : Chart(filename, false, resource)
     {
     }
 
@@ -102,7 +139,7 @@ namespace ksh
         std::ostringstream oss;
 
         // Output order-sensitive keys
-        std::unordered_map<std::string, bool> finished;
+        std::unordered_map<std::string_view, bool> finished;
         for (auto && key : {
             "title",
             "title_img",
@@ -130,14 +167,20 @@ namespace ksh
             }
         }
 
-        // Output remaining keys
+        // Output remaining keys (sorted, so that the output does not depend on the hash order)
+        std::vector<const decltype(metaData)::value_type *> remainingParams;
         for (auto && param : metaData)
         {
             if (finished.count(param.first) == 0)
             {
-                oss << param.first << "=" << param.second << "\r\n";
+                remainingParams.push_back(&param);
             }
         }
+        std::sort(remainingParams.begin(), remainingParams.end(), [](const auto * lhs, const auto * rhs) { return lhs->first < rhs->first; });
+        for (const auto * param : remainingParams)
+        {
+            oss << param->first << "=" << param->second << "\r\n";
+        }
 
         oss << std::flush;
 
@@ -146,16 +189,19 @@ namespace ksh
 
     int Chart::kshVersionInt() const
     {
-        int chartVersion;
+        int chartVersion = 100;
         if (metaData.count("ver"))
         {
-            chartVersion = std::stoi(metaData.at("ver"));
-        }
-        else
-        {
-            chartVersion = 100;
+            // Non-numeric versions are regarded as the oldest one
+            const std::string ver(metaData.at("ver"));
+            char * end;
+            const long value = std::strtol(ver.c_str(), &end, 10);
+            if (end != ver.c_str())
+            {
+                chartVersion = static_cast<int>(value);
+            }
         }
-        
+
         return chartVersion;
     }
 
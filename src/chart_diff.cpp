@@ -0,0 +1,215 @@
+#include "ksh/chart_diff.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace ksh
+{
+
+    namespace
+    {
+        bool contentEquals(const TimeSig & a, const TimeSig & b)
+        {
+            return a.numerator == b.numerator && a.denominator == b.denominator;
+        }
+
+        bool contentEquals(const BTNote & a, const BTNote & b)
+        {
+            return a.length == b.length;
+        }
+
+        bool contentEquals(const FXNote & a, const FXNote & b)
+        {
+            return a.length == b.length
+                && a.audioEffectStr == b.audioEffectStr
+                && a.audioEffectParamStr == b.audioEffectParamStr;
+        }
+
+        bool contentEquals(const LaneSpin & a, const LaneSpin & b)
+        {
+            if (!a.isValid() || !b.isValid())
+            {
+                return a.isValid() == b.isValid();
+            }
+            return a.type == b.type
+                && a.direction == b.direction
+                && a.length == b.length
+                && (a.type != LaneSpin::Type::Swing
+                    || (a.swingAmplitude == b.swingAmplitude && a.swingFrequency == b.swingFrequency && a.swingDecayOrder == b.swingDecayOrder));
+        }
+
+        bool contentEquals(const LaserNote & a, const LaserNote & b)
+        {
+            return a.length == b.length
+                && a.startX == b.startX
+                && a.endX == b.endX
+                && contentEquals(a.laneSpin, b.laneSpin);
+        }
+
+        template <typename T>
+        bool contentEquals(const T & a, const T & b)
+        {
+            return a == b;
+        }
+
+        // Values of a header entry or a positional option (compared by content instead of by address)
+        template <typename T>
+        bool contentEquals(const T * a, const T * b)
+        {
+            return contentEquals(*a, *b);
+        }
+
+        // Merge two sorted ranges of (key, value) pairs (equal keys are paired in order, which also handles multimaps)
+        template <typename Key, typename T, class Range>
+        void diffSorted(const Range & before, const Range & after, std::vector<DiffEntry<Key, T>> & entries)
+        {
+            auto beforeItr = std::begin(before);
+            auto afterItr = std::begin(after);
+            const auto beforeEnd = std::end(before);
+            const auto afterEnd = std::end(after);
+            while (beforeItr != beforeEnd || afterItr != afterEnd)
+            {
+                if (afterItr == afterEnd || (beforeItr != beforeEnd && beforeItr->first < afterItr->first))
+                {
+                    entries.push_back({ DiffKind::Removed, Key(beforeItr->first), &beforeItr->second, nullptr });
+                    ++beforeItr;
+                }
+                else if (beforeItr == beforeEnd || afterItr->first < beforeItr->first)
+                {
+                    entries.push_back({ DiffKind::Added, Key(afterItr->first), nullptr, &afterItr->second });
+                    ++afterItr;
+                }
+                else
+                {
+                    if (!contentEquals(beforeItr->second, afterItr->second))
+                    {
+                        entries.push_back({ DiffKind::Modified, Key(beforeItr->first), &beforeItr->second, &afterItr->second });
+                    }
+                    ++beforeItr;
+                    ++afterItr;
+                }
+            }
+        }
+
+        // Entries of an unordered map sorted by key
+        template <class Map>
+        std::vector<std::pair<std::string_view, const typename Map::mapped_type *>> sortedEntries(const Map & map)
+        {
+            std::vector<std::pair<std::string_view, const typename Map::mapped_type *>> entries;
+            entries.reserve(map.size());
+            for (const auto & [ key, value ] : map)
+            {
+                entries.emplace_back(key, &value);
+            }
+            std::sort(entries.begin(), entries.end(), [](const auto & a, const auto & b) { return a.first < b.first; });
+            return entries;
+        }
+
+        // Replace the pointers to the pointers in entries of sortedEntries() with the pointers themselves
+        template <typename T>
+        std::vector<DiffEntry<std::string_view, T>> unwrapEntries(const std::vector<DiffEntry<std::string_view, const T *>> & entries)
+        {
+            std::vector<DiffEntry<std::string_view, T>> unwrapped;
+            unwrapped.reserve(entries.size());
+            for (const auto & entry : entries)
+            {
+                unwrapped.push_back({ entry.kind, entry.key, entry.before ? *entry.before : nullptr, entry.after ? *entry.after : nullptr });
+            }
+            return unwrapped;
+        }
+    }
+
+    template <class Layout>
+    std::size_t BasicChartDiff<Layout>::size() const
+    {
+        std::size_t count = metaData.size() + tempoChanges.size() + timeSigChanges.size()
+            + zoomTop.size() + zoomBottom.size() + zoomSide.size() + centerSplit.size() + manualTilt.size();
+        for (const auto & lane : btLanes)
+        {
+            count += lane.size();
+        }
+        for (const auto & lane : fxLanes)
+        {
+            count += lane.size();
+        }
+        for (const auto & lane : laserLanes)
+        {
+            count += lane.size();
+        }
+        for (const auto & [ key, entries ] : positionalOptions)
+        {
+            count += entries.size();
+        }
+        return count;
+    }
+
+    template <class Layout>
+    BasicChartDiff<Layout> diffCharts(const BasicPlayableChart<Layout> & before, const BasicPlayableChart<Layout> & after)
+    {
+        BasicChartDiff<Layout> diff;
+
+        // Header (unordered, so compare by sorted keys)
+        {
+            // (entries point into beforeEntries and afterEntries, so they must outlive unwrapEntries())
+            const auto beforeEntries = sortedEntries(before.metaData);
+            const auto afterEntries = sortedEntries(after.metaData);
+            std::vector<DiffEntry<std::string_view, const std::pmr::string *>> entries;
+            diffSorted(beforeEntries, afterEntries, entries);
+            diff.metaData = unwrapEntries(entries);
+        }
+
+        // Beat map
+        diffSorted(before.beatMap().tempoChanges(), after.beatMap().tempoChanges(), diff.tempoChanges);
+        diffSorted(before.beatMap().timeSigChanges(), after.beatMap().timeSigChanges(), diff.timeSigChanges);
+
+        // Notes
+        for (std::size_t i = 0; i < Layout::BT_LANE_COUNT; ++i)
+        {
+            diffSorted(before.btLane(i), after.btLane(i), diff.btLanes[i]);
+        }
+        for (std::size_t i = 0; i < Layout::FX_LANE_COUNT; ++i)
+        {
+            diffSorted(before.fxLane(i), after.fxLane(i), diff.fxLanes[i]);
+        }
+        for (std::size_t i = 0; i < Layout::LASER_LANE_COUNT; ++i)
+        {
+            diffSorted(before.laserLane(i), after.laserLane(i), diff.laserLanes[i]);
+        }
+
+        // Line graphs
+        diffSorted(before.zoomTop(), after.zoomTop(), diff.zoomTop);
+        diffSorted(before.zoomBottom(), after.zoomBottom(), diff.zoomBottom);
+        diffSorted(before.zoomSide(), after.zoomSide(), diff.zoomSide);
+        diffSorted(before.centerSplit(), after.centerSplit(), diff.centerSplit);
+        diffSorted(before.manualTilt(), after.manualTilt(), diff.manualTilt);
+
+        // Positional options (options whose keys exist in only one chart are compared with empty values)
+        {
+            // (entries point into beforeEntries and afterEntries, so they must outlive the loop)
+            const auto beforeEntries = sortedEntries(before.positionalOptions());
+            const auto afterEntries = sortedEntries(after.positionalOptions());
+            std::vector<DiffEntry<std::string_view, const PositionalOptions::mapped_type *>> entries;
+            diffSorted(beforeEntries, afterEntries, entries);
+
+            const PositionalOptions::mapped_type emptyValues;
+            for (const auto & entry : entries)
+            {
+                MeasureDiff<std::pmr::string> valueEntries;
+                diffSorted(entry.before ? **entry.before : emptyValues, entry.after ? **entry.after : emptyValues, valueEntries);
+                if (!valueEntries.empty())
+                {
+                    diff.positionalOptions.emplace_back(entry.key, std::move(valueEntries));
+                }
+            }
+        }
+
+        return diff;
+    }
+
+    template struct BasicChartDiff<DefaultLaneLayout>;
+    template struct BasicChartDiff<SixBTLaneLayout>;
+    template BasicChartDiff<DefaultLaneLayout> diffCharts(const BasicPlayableChart<DefaultLaneLayout> &, const BasicPlayableChart<DefaultLaneLayout> &);
+    template BasicChartDiff<SixBTLaneLayout> diffCharts(const BasicPlayableChart<SixBTLaneLayout> &, const BasicPlayableChart<SixBTLaneLayout> &);
+
+}
@@ -0,0 +1,296 @@
+#include "ksh/chart_fingerprint.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+namespace ksh
+{
+
+    namespace
+    {
+        // Bump this when the canonical content changes so that old cache keys are invalidated
+        constexpr uint64_t FINGERPRINT_FORMAT_VERSION = 1;
+
+        constexpr uint64_t C1 = 0x87C37B91114253D5ULL;
+        constexpr uint64_t C2 = 0x4CF5AD432745937FULL;
+
+        constexpr uint64_t rotl64(uint64_t x, int r)
+        {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        constexpr uint64_t fmix64(uint64_t k)
+        {
+            k ^= k >> 33;
+            k *= 0xFF51AFD7ED558CCDULL;
+            k ^= k >> 33;
+            k *= 0xC4CEB9FE1A85EC53ULL;
+            k ^= k >> 33;
+            return k;
+        }
+
+        // Little-endian load (independent of the host byte order so that fingerprints are portable)
+        uint64_t loadLE64(const unsigned char * p)
+        {
+            uint64_t v = 0;
+            for (int i = 7; i >= 0; --i)
+            {
+                v = (v << 8) | p[i];
+            }
+            return v;
+        }
+
+        // Incremental MurmurHash3 x64 128
+        class Hasher128
+        {
+        private:
+            uint64_t m_h1;
+            uint64_t m_h2;
+            unsigned char m_buffer[16];
+            std::size_t m_bufferSize;
+            uint64_t m_totalSize;
+
+            void mixBlock(const unsigned char * block)
+            {
+                uint64_t k1 = loadLE64(block);
+                uint64_t k2 = loadLE64(block + 8);
+
+                k1 *= C1; k1 = rotl64(k1, 31); k1 *= C2; m_h1 ^= k1;
+                m_h1 = rotl64(m_h1, 27); m_h1 += m_h2; m_h1 = m_h1 * 5 + 0x52DCE729;
+
+                k2 *= C2; k2 = rotl64(k2, 33); k2 *= C1; m_h2 ^= k2;
+                m_h2 = rotl64(m_h2, 31); m_h2 += m_h1; m_h2 = m_h2 * 5 + 0x38495AB5;
+            }
+
+        public:
+            explicit Hasher128(uint64_t seed)
+                : m_h1(seed)
+                , m_h2(seed)
+                , m_buffer{}
+                , m_bufferSize(0)
+                , m_totalSize(0)
+            {
+            }
+
+            void update(const void * data, std::size_t size)
+            {
+                const unsigned char * p = static_cast<const unsigned char *>(data);
+                m_totalSize += size;
+
+                if (m_bufferSize > 0)
+                {
+                    const std::size_t n = std::min(size, 16 - m_bufferSize);
+                    std::memcpy(m_buffer + m_bufferSize, p, n);
+                    m_bufferSize += n;
+                    p += n;
+                    size -= n;
+                    if (m_bufferSize < 16)
+                    {
+                        return;
+                    }
+                    mixBlock(m_buffer);
+                    m_bufferSize = 0;
+                }
+
+                while (size >= 16)
+                {
+                    mixBlock(p);
+                    p += 16;
+                    size -= 16;
+                }
+
+                std::memcpy(m_buffer, p, size);
+                m_bufferSize = size;
+            }
+
+            void updateInt(int64_t value)
+            {
+                unsigned char bytes[8];
+                for (int i = 0; i < 8; ++i)
+                {
+                    bytes[i] = static_cast<unsigned char>(static_cast<uint64_t>(value) >> (i * 8));
+                }
+                update(bytes, sizeof(bytes));
+            }
+
+            void updateDouble(double value)
+            {
+                if (value == 0.0)
+                {
+                    value = 0.0; // -0.0 and 0.0 are the same value
+                }
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                updateInt(static_cast<int64_t>(bits));
+            }
+
+            void updateString(std::string_view str)
+            {
+                // Length prefix keeps ("ab", "c") and ("a", "bc") apart
+                updateInt(static_cast<int64_t>(str.size()));
+                update(str.data(), str.size());
+            }
+
+            ChartFingerprint finish()
+            {
+                uint64_t k1 = 0;
+                uint64_t k2 = 0;
+                const unsigned char * tail = m_buffer;
+
+                switch (m_bufferSize)
+                {
+                case 15: k2 ^= static_cast<uint64_t>(tail[14]) << 48; [[fallthrough]];
+                case 14: k2 ^= static_cast<uint64_t>(tail[13]) << 40; [[fallthrough]];
+                case 13: k2 ^= static_cast<uint64_t>(tail[12]) << 32; [[fallthrough]];
+                case 12: k2 ^= static_cast<uint64_t>(tail[11]) << 24; [[fallthrough]];
+                case 11: k2 ^= static_cast<uint64_t>(tail[10]) << 16; [[fallthrough]];
+                case 10: k2 ^= static_cast<uint64_t>(tail[9]) << 8; [[fallthrough]];
+                case 9:
+                    k2 ^= static_cast<uint64_t>(tail[8]);
+                    k2 *= C2; k2 = rotl64(k2, 33); k2 *= C1; m_h2 ^= k2;
+                    [[fallthrough]];
+                case 8: k1 ^= static_cast<uint64_t>(tail[7]) << 56; [[fallthrough]];
+                case 7: k1 ^= static_cast<uint64_t>(tail[6]) << 48; [[fallthrough]];
+                case 6: k1 ^= static_cast<uint64_t>(tail[5]) << 40; [[fallthrough]];
+                case 5: k1 ^= static_cast<uint64_t>(tail[4]) << 32; [[fallthrough]];
+                case 4: k1 ^= static_cast<uint64_t>(tail[3]) << 24; [[fallthrough]];
+                case 3: k1 ^= static_cast<uint64_t>(tail[2]) << 16; [[fallthrough]];
+                case 2: k1 ^= static_cast<uint64_t>(tail[1]) << 8; [[fallthrough]];
+                case 1:
+                    k1 ^= static_cast<uint64_t>(tail[0]);
+                    k1 *= C1; k1 = rotl64(k1, 31); k1 *= C2; m_h1 ^= k1;
+                    break;
+                default:
+                    break;
+                }
+
+                m_h1 ^= m_totalSize;
+                m_h2 ^= m_totalSize;
+                m_h1 += m_h2;
+                m_h2 += m_h1;
+                m_h1 = fmix64(m_h1);
+                m_h2 = fmix64(m_h2);
+                m_h1 += m_h2;
+                m_h2 += m_h1;
+
+                return ChartFingerprint{ m_h1, m_h2 };
+            }
+        };
+
+        void hashLineGraph(Hasher128 & hasher, const LineGraph & graph)
+        {
+            hasher.updateInt(static_cast<int64_t>(graph.size()));
+            for (const auto & [ y, plot ] : graph)
+            {
+                hasher.updateInt(y);
+                hasher.updateDouble(plot.first);
+                hasher.updateDouble(plot.second);
+            }
+        }
+    }
+
+    std::string ChartFingerprint::toString() const
+    {
+        constexpr char HEX_DIGITS[] = "0123456789abcdef";
+        std::string str(32, '0');
+        for (int i = 0; i < 16; ++i)
+        {
+            str[15 - i] = HEX_DIGITS[(high >> (i * 4)) & 0xF];
+            str[31 - i] = HEX_DIGITS[(low >> (i * 4)) & 0xF];
+        }
+        return str;
+    }
+
+    ChartFingerprint computeFingerprint(const PlayableChart & chart)
+    {
+        Hasher128 hasher(FINGERPRINT_FORMAT_VERSION);
+
+        // Beat map
+        const BeatMap & beatMap = chart.beatMap();
+        hasher.updateInt(static_cast<int64_t>(beatMap.tempoChanges().size()));
+        for (const auto & [ y, tempo ] : beatMap.tempoChanges())
+        {
+            hasher.updateInt(y);
+            hasher.updateDouble(tempo);
+        }
+        hasher.updateInt(static_cast<int64_t>(beatMap.timeSigChanges().size()));
+        for (const auto & [ measureCount, timeSig ] : beatMap.timeSigChanges())
+        {
+            hasher.updateInt(measureCount);
+            hasher.updateInt(timeSig.numerator);
+            hasher.updateInt(timeSig.denominator);
+        }
+
+        // Notes
+        for (const auto & lane : chart.btLanes())
+        {
+            hasher.updateInt(static_cast<int64_t>(lane.size()));
+            for (const auto & [ y, note ] : lane)
+            {
+                hasher.updateInt(y);
+                hasher.updateInt(note.length);
+            }
+        }
+        for (const auto & lane : chart.fxLanes())
+        {
+            hasher.updateInt(static_cast<int64_t>(lane.size()));
+            for (const auto & [ y, note ] : lane)
+            {
+                hasher.updateInt(y);
+                hasher.updateInt(note.length);
+                hasher.updateString(note.audioEffectStr);
+                hasher.updateString(note.audioEffectParamStr);
+            }
+        }
+        for (const auto & lane : chart.laserLanes())
+        {
+            hasher.updateInt(static_cast<int64_t>(lane.size()));
+            for (const auto & [ y, note ] : lane)
+            {
+                hasher.updateInt(y);
+                hasher.updateInt(note.length);
+                hasher.updateInt(note.startX);
+                hasher.updateInt(note.endX);
+                hasher.updateInt(static_cast<int64_t>(note.laneSpin.type));
+                hasher.updateInt(static_cast<int64_t>(note.laneSpin.direction));
+                hasher.updateInt(note.laneSpin.length);
+                hasher.updateInt(note.laneSpin.swingAmplitude);
+                hasher.updateInt(static_cast<int64_t>(note.laneSpin.swingFrequency));
+                hasher.updateInt(note.laneSpin.swingDecayOrder);
+            }
+        }
+
+        // Line graphs
+        hashLineGraph(hasher, chart.zoomTop());
+        hashLineGraph(hasher, chart.zoomBottom());
+        hashLineGraph(hasher, chart.zoomSide());
+        hashLineGraph(hasher, chart.centerSplit());
+        hashLineGraph(hasher, chart.manualTilt());
+
+        // Positional options (sorted by key because the container is unordered)
+        const auto & positionalOptions = chart.positionalOptions();
+        std::vector<const std::pmr::string *> keys;
+        keys.reserve(positionalOptions.size());
+        for (const auto & pair : positionalOptions)
+        {
+            keys.push_back(&pair.first);
+        }
+        std::sort(keys.begin(), keys.end(), [](const std::pmr::string * a, const std::pmr::string * b) { return *a < *b; });
+        hasher.updateInt(static_cast<int64_t>(keys.size()));
+        for (const std::pmr::string * key : keys)
+        {
+            const auto & values = positionalOptions.at(*key);
+            hasher.updateString(*key);
+            hasher.updateInt(static_cast<int64_t>(values.size()));
+            for (const auto & [ y, value ] : values)
+            {
+                hasher.updateInt(y);
+                hasher.updateString(value);
+            }
+        }
+
+        return hasher.finish();
+    }
+
+}
@@ -0,0 +1,427 @@
+#include "ksh/chart_json.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace ksh
+{
+
+    namespace
+    {
+        constexpr int JSON_FORMAT_VERSION = 1;
+
+        constexpr std::size_t FLUSH_THRESHOLD = 64 * 1024;
+
+        // Minimal streaming JSON writer
+        // (appends to a string buffer; if an output stream is given, the buffer is flushed to it so that its capacity is reused)
+        class JSONWriter
+        {
+        private:
+            std::string & m_buffer;
+            std::ostream * const m_os;
+
+            // Bit n: whether the container at depth n already has an element (needs a comma before the next one)
+            uint64_t m_hasElement;
+            int m_depth;
+
+            bool m_afterKey;
+
+            void beginValue()
+            {
+                if (m_afterKey)
+                {
+                    m_afterKey = false;
+                    return;
+                }
+                if (m_hasElement & (uint64_t{ 1 } << m_depth))
+                {
+                    m_buffer.push_back(',');
+                }
+                m_hasElement |= uint64_t{ 1 } << m_depth;
+            }
+
+            void beginContainer(char c)
+            {
+                beginValue();
+                m_buffer.push_back(c);
+                ++m_depth;
+                m_hasElement &= ~(uint64_t{ 1 } << m_depth);
+            }
+
+            void endContainer(char c)
+            {
+                --m_depth;
+                m_buffer.push_back(c);
+                flushIfFull();
+            }
+
+            void appendEscaped(std::string_view str)
+            {
+                constexpr char HEX_DIGITS[] = "0123456789abcdef";
+                m_buffer.push_back('"');
+                std::size_t runStart = 0;
+                for (std::size_t i = 0; i < str.size(); ++i)
+                {
+                    const unsigned char c = static_cast<unsigned char>(str[i]);
+                    if (c >= 0x20 && c != '"' && c != '\\')
+                    {
+                        continue;
+                    }
+
+                    m_buffer.append(str.data() + runStart, i - runStart);
+                    runStart = i + 1;
+                    switch (c)
+                    {
+                    case '"':  m_buffer.append("\\\""); break;
+                    case '\\': m_buffer.append("\\\\"); break;
+                    case '\n': m_buffer.append("\\n"); break;
+                    case '\r': m_buffer.append("\\r"); break;
+                    case '\t': m_buffer.append("\\t"); break;
+                    default:
+                        m_buffer.append("\\u00");
+                        m_buffer.push_back(HEX_DIGITS[c >> 4]);
+                        m_buffer.push_back(HEX_DIGITS[c & 0xF]);
+                        break;
+                    }
+                }
+                m_buffer.append(str.data() + runStart, str.size() - runStart);
+                m_buffer.push_back('"');
+            }
+
+        public:
+            JSONWriter(std::string & buffer, std::ostream * os)
+                : m_buffer(buffer)
+                , m_os(os)
+                , m_hasElement(0)
+                , m_depth(0)
+                , m_afterKey(false)
+            {
+            }
+
+            void flush()
+            {
+                if (m_os != nullptr && !m_buffer.empty())
+                {
+                    m_os->write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+                    m_buffer.clear();
+                }
+            }
+
+            void flushIfFull()
+            {
+                if (m_os != nullptr && m_buffer.size() >= FLUSH_THRESHOLD)
+                {
+                    flush();
+                }
+            }
+
+            void beginObject()
+            {
+                beginContainer('{');
+            }
+
+            void endObject()
+            {
+                endContainer('}');
+            }
+
+            void beginArray()
+            {
+                beginContainer('[');
+            }
+
+            void endArray()
+            {
+                endContainer(']');
+            }
+
+            void key(std::string_view str)
+            {
+                beginValue();
+                appendEscaped(str);
+                m_buffer.push_back(':');
+                m_afterKey = true;
+            }
+
+            void value(std::string_view str)
+            {
+                beginValue();
+                appendEscaped(str);
+            }
+
+            void value(int64_t v)
+            {
+                beginValue();
+                char buf[24];
+                const auto result = std::to_chars(buf, buf + sizeof(buf), v);
+                m_buffer.append(buf, result.ptr);
+            }
+
+            void value(double v)
+            {
+                beginValue();
+                if (!std::isfinite(v))
+                {
+                    m_buffer.append("null");
+                    return;
+                }
+                char buf[32];
+                const auto result = std::to_chars(buf, buf + sizeof(buf), v); // Shortest representation that round-trips
+                m_buffer.append(buf, result.ptr);
+            }
+
+            // Append a raw string token built from parts (for lane spin strings without a temporary std::string)
+            void beginRawString()
+            {
+                beginValue();
+                m_buffer.push_back('"');
+            }
+
+            void appendRaw(std::string_view str)
+            {
+                m_buffer.append(str);
+            }
+
+            void appendRaw(int64_t v)
+            {
+                char buf[24];
+                const auto result = std::to_chars(buf, buf + sizeof(buf), v);
+                m_buffer.append(buf, result.ptr);
+            }
+
+            void endRawString()
+            {
+                m_buffer.push_back('"');
+            }
+        };
+
+        template <class Map>
+        std::vector<typename Map::const_pointer> sortedByKey(const Map & map)
+        {
+            std::vector<typename Map::const_pointer> pairs;
+            pairs.reserve(map.size());
+            for (const auto & pair : map)
+            {
+                pairs.push_back(&pair);
+            }
+            std::sort(pairs.begin(), pairs.end(), [](auto a, auto b) { return a->first < b->first; });
+            return pairs;
+        }
+
+        void writeLineGraph(JSONWriter & writer, std::string_view key, const LineGraph & graph)
+        {
+            writer.key(key);
+            writer.beginArray();
+            for (const auto & [ y, plot ] : graph)
+            {
+                writer.beginArray();
+                writer.value(static_cast<int64_t>(y));
+                writer.value(plot.first);
+                if (plot.second != plot.first)
+                {
+                    writer.value(plot.second);
+                }
+                writer.endArray();
+            }
+            writer.endArray();
+        }
+
+        // Same format as "@(192" or "S>192;250;3;2" in .ksh
+        void writeLaneSpin(JSONWriter & writer, const LaneSpin & laneSpin)
+        {
+            const bool left = (laneSpin.direction == LaneSpin::Direction::Left);
+            writer.beginRawString();
+            switch (laneSpin.type)
+            {
+            case LaneSpin::Type::Normal:
+                writer.appendRaw(left ? "@(" : "@)");
+                break;
+            case LaneSpin::Type::Half:
+                writer.appendRaw(left ? "@<" : "@>");
+                break;
+            default:
+                writer.appendRaw(left ? "S<" : "S>");
+                break;
+            }
+            writer.appendRaw(static_cast<int64_t>(laneSpin.length * 192 / UNIT_MEASURE));
+            if (laneSpin.type == LaneSpin::Type::Swing)
+            {
+                writer.appendRaw(";");
+                writer.appendRaw(static_cast<int64_t>(laneSpin.swingAmplitude));
+                writer.appendRaw(";");
+                writer.appendRaw(static_cast<int64_t>(laneSpin.swingFrequency));
+                writer.appendRaw(";");
+                writer.appendRaw(static_cast<int64_t>(laneSpin.swingDecayOrder));
+            }
+            writer.endRawString();
+        }
+
+        void writeChart(JSONWriter & writer, const PlayableChart & chart)
+        {
+            writer.beginObject();
+
+            writer.key("format_version");
+            writer.value(static_cast<int64_t>(JSON_FORMAT_VERSION));
+
+            // Header
+            writer.key("meta");
+            writer.beginObject();
+            for (const auto * pair : sortedByKey(chart.metaData))
+            {
+                writer.key(pair->first);
+                writer.value(pair->second);
+            }
+            writer.endObject();
+
+            // Beat map
+            const BeatMap & beatMap = chart.beatMap();
+            writer.key("beat");
+            writer.beginObject();
+            writer.key("bpm");
+            writer.beginArray();
+            for (const auto & [ y, tempo ] : beatMap.tempoChanges())
+            {
+                writer.beginArray();
+                writer.value(static_cast<int64_t>(y));
+                writer.value(tempo);
+                writer.endArray();
+            }
+            writer.endArray();
+            writer.key("time_sig");
+            writer.beginArray();
+            for (const auto & [ measureIdx, timeSig ] : beatMap.timeSigChanges())
+            {
+                writer.beginArray();
+                writer.value(static_cast<int64_t>(measureIdx));
+                writer.beginArray();
+                writer.value(static_cast<int64_t>(timeSig.numerator));
+                writer.value(static_cast<int64_t>(timeSig.denominator));
+                writer.endArray();
+                writer.endArray();
+            }
+            writer.endArray();
+            writer.endObject();
+
+            // Notes
+            writer.key("note");
+            writer.beginObject();
+            writer.key("bt");
+            writer.beginArray();
+            for (const auto & lane : chart.btLanes())
+            {
+                writer.beginArray();
+                for (const auto & [ y, note ] : lane)
+                {
+                    writer.beginArray();
+                    writer.value(static_cast<int64_t>(y));
+                    writer.value(static_cast<int64_t>(note.length));
+                    writer.endArray();
+                }
+                writer.endArray();
+            }
+            writer.endArray();
+            writer.key("fx");
+            writer.beginArray();
+            for (const auto & lane : chart.fxLanes())
+            {
+                writer.beginArray();
+                for (const auto & [ y, note ] : lane)
+                {
+                    writer.beginArray();
+                    writer.value(static_cast<int64_t>(y));
+                    writer.value(static_cast<int64_t>(note.length));
+                    if (!note.audioEffectStr.empty() || !note.audioEffectParamStr.empty())
+                    {
+                        writer.value(note.audioEffectStr);
+                        if (!note.audioEffectParamStr.empty())
+                        {
+                            writer.value(note.audioEffectParamStr);
+                        }
+                    }
+                    writer.endArray();
+                }
+                writer.endArray();
+            }
+            writer.endArray();
+            writer.key("laser");
+            writer.beginArray();
+            for (const auto & lane : chart.laserLanes())
+            {
+                writer.beginArray();
+                for (const auto & [ y, note ] : lane)
+                {
+                    writer.beginArray();
+                    writer.value(static_cast<int64_t>(y));
+                    writer.value(static_cast<int64_t>(note.length));
+                    writer.value(static_cast<int64_t>(note.startX));
+                    writer.value(static_cast<int64_t>(note.endX));
+                    if (note.laneSpin.isValid())
+                    {
+                        writeLaneSpin(writer, note.laneSpin);
+                    }
+                    writer.endArray();
+                }
+                writer.endArray();
+            }
+            writer.endArray();
+            writer.endObject();
+
+            // Line graphs
+            writer.key("camera");
+            writer.beginObject();
+            writeLineGraph(writer, "zoom_top", chart.zoomTop());
+            writeLineGraph(writer, "zoom_bottom", chart.zoomBottom());
+            writeLineGraph(writer, "zoom_side", chart.zoomSide());
+            writeLineGraph(writer, "center_split", chart.centerSplit());
+            writeLineGraph(writer, "manual_tilt", chart.manualTilt());
+            writer.endObject();
+
+            // Positional options
+            writer.key("options");
+            writer.beginObject();
+            for (const auto * pair : sortedByKey(chart.positionalOptions()))
+            {
+                writer.key(pair->first);
+                writer.beginArray();
+                for (const auto & [ y, value ] : pair->second)
+                {
+                    writer.beginArray();
+                    writer.value(static_cast<int64_t>(y));
+                    writer.value(value);
+                    writer.endArray();
+                }
+                writer.endArray();
+            }
+            writer.endObject();
+
+            writer.endObject();
+        }
+    }
+
+    void writeChartJSON(std::ostream & os, const PlayableChart & chart)
+    {
+        std::string buffer;
+        buffer.reserve(FLUSH_THRESHOLD + 4096);
+        JSONWriter writer(buffer, &os);
+        writeChart(writer, chart);
+        writer.flush();
+    }
+
+    void appendChartJSON(std::string & str, const PlayableChart & chart)
+    {
+        JSONWriter writer(str, nullptr);
+        writeChart(writer, chart);
+    }
+
+    std::string chartToJSON(const PlayableChart & chart)
+    {
+        std::string str;
+        appendChartJSON(str, chart);
+        return str;
+    }
+
+}
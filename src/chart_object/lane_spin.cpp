@@ -1,14 +1,33 @@
 #include "ksh/chart_object/lane_spin.hpp"
 
-#include <sstream>
 #include <array>
+#include <algorithm>
 #include <tuple>
+#include <optional>
+#include <cstdlib>
 #include "ksh/beat_map/time_sig.hpp"
 
-Measure kshLengthToMeasure(const std::string & str)
+// Parse an integer like std::stoll() but without exceptions (std::nullopt if str does not start with a number)
+std::optional<long long> parseInteger(const std::string & str)
 {
-    // TODO: catch the exception from stoi
-    return std::stoll(str) * UNIT_MEASURE / 192;
+    const char * begin = str.c_str();
+    char * end;
+    const long long value = std::strtoll(begin, &end, 10);
+    if (end == begin)
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::optional<Measure> kshLengthToMeasure(const std::string & str)
+{
+    const std::optional<long long> length = parseInteger(str);
+    if (!length)
+    {
+        return std::nullopt;
+    }
+    return *length * UNIT_MEASURE / 192;
 }
 
 std::string measureToKshLength(Measure measure)
@@ -16,26 +35,37 @@ std::string measureToKshLength(Measure measure)
     return std::to_string(measure * 192 / UNIT_MEASURE);
 }
 
-std::tuple<Measure, int, std::size_t, int> splitSwingParams(const std::string & paramStr)
+std::optional<std::tuple<Measure, int, std::size_t, int>> splitSwingParams(const std::string & paramStr)
 {
     std::array<std::string, 4> params{
         "192", "250", "3", "2"
     };
 
-    std::stringstream ss(paramStr);
-    std::string s;
-    int i = 0;
-    while (i < 4 && std::getline(ss, s, ';'))
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < params.size() && pos <= paramStr.size(); ++i)
+    {
+        const std::size_t semicolonIdx = std::min(paramStr.find(';', pos), paramStr.size());
+        if (semicolonIdx > pos || semicolonIdx < paramStr.size())
+        {
+            params[i] = paramStr.substr(pos, semicolonIdx - pos);
+        }
+        pos = semicolonIdx + 1;
+    }
+
+    const std::optional<Measure> length = kshLengthToMeasure(params[0]);
+    const std::optional<long long> amplitude = parseInteger(params[1]);
+    const std::optional<long long> frequency = parseInteger(params[2]);
+    const std::optional<long long> decayOrder = parseInteger(params[3]);
+    if (!length || !amplitude || !frequency || !decayOrder)
     {
-        params[i] = s;
-        ++i;
+        return std::nullopt;
     }
 
     return std::make_tuple(
-        kshLengthToMeasure(params[0]),
-        std::stoi(params[1]),
-        static_cast<std::size_t>(std::stoll(params[2])),
-        std::stoi(params[3]));
+        *length,
+        static_cast<int>(*amplitude),
+        static_cast<std::size_t>(*frequency),
+        static_cast<int>(*decayOrder));
 }
 
 LaneSpin::LaneSpin(const std::string & strFromKsh)
@@ -113,11 +143,33 @@ LaneSpin::LaneSpin(const std::string & strFromKsh)
     }
     else if (type == Type::Swing)
     {
-        std::tie(length, swingAmplitude, swingFrequency, swingDecayOrder) = splitSwingParams(strFromKsh.substr(2));
+        const auto swingParams = splitSwingParams(strFromKsh.substr(2));
+        if (swingParams)
+        {
+            std::tie(length, swingAmplitude, swingFrequency, swingDecayOrder) = *swingParams;
+        }
+        else
+        {
+            // Invalid number
+            type = Type::NoSpin;
+            direction = Direction::Unspecified;
+            length = 0;
+        }
     }
     else
     {
-        length = kshLengthToMeasure(strFromKsh.substr(2));
+        const std::optional<Measure> spinLength = kshLengthToMeasure(strFromKsh.substr(2));
+        if (spinLength)
+        {
+            length = *spinLength;
+        }
+        else
+        {
+            // Invalid number
+            type = Type::NoSpin;
+            direction = Direction::Unspecified;
+            length = 0;
+        }
     }
 }
 
@@ -0,0 +1,95 @@
+#include "ksh/chart_object/lane_spin_track.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    constexpr double PI = 3.14159265358979323846;
+}
+
+LaneTransform LaneSpinTrack::Keyframe::transformAt(Ms ms) const
+{
+    LaneTransform transform;
+    if (ms < startMs || ms >= endMs)
+    {
+        return transform;
+    }
+
+    const double t = (ms - startMs) / (endMs - startMs);
+    switch (type)
+    {
+    case LaneSpin::Type::Normal:
+        transform.rotation = sign * (1.0 - (1.0 - t) * (1.0 - t));
+        break;
+
+    case LaneSpin::Type::Half:
+        transform.rotation = sign * 0.5 * std::sin(PI * t);
+        break;
+
+    case LaneSpin::Type::Swing:
+        transform.swing = sign * swingAmplitude * std::sin(2.0 * PI * swingFrequency * t) * std::pow(1.0 - t, swingDecayOrder);
+        break;
+
+    default:
+        break;
+    }
+    return transform;
+}
+
+LaneSpinTrack::LaneSpinTrack(const std::map<Measure, LaneSpin> & laneSpins, const BeatMap & beatMap)
+{
+    m_keyframes.reserve(laneSpins.size());
+    for (const auto & [ y, laneSpin ] : laneSpins)
+    {
+        if (!laneSpin.isValid() || laneSpin.length <= 0)
+        {
+            continue;
+        }
+
+        Keyframe keyframe;
+        keyframe.startMs = beatMap.measureToMs(y);
+        keyframe.endMs = beatMap.measureToMs(y + laneSpin.length);
+        keyframe.type = laneSpin.type;
+        keyframe.sign = (laneSpin.direction == LaneSpin::Direction::Left) ? -1.0 : 1.0;
+        keyframe.swingAmplitude = static_cast<double>(laneSpin.swingAmplitude);
+        keyframe.swingFrequency = static_cast<double>(laneSpin.swingFrequency);
+        keyframe.swingDecayOrder = laneSpin.swingDecayOrder;
+        m_keyframes.push_back(keyframe);
+    }
+}
+
+LaneTransform LaneSpinTrack::transformAt(std::size_t nextIdx, Ms ms) const
+{
+    // The latest spin that has started is the active one
+    if (nextIdx == 0)
+    {
+        return LaneTransform();
+    }
+    return m_keyframes[nextIdx - 1].transformAt(ms);
+}
+
+LaneTransform LaneSpinTrack::transformAt(Ms ms) const
+{
+    const auto itr = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), ms, [](Ms value, const Keyframe & keyframe) { return value < keyframe.startMs; });
+    return transformAt(static_cast<std::size_t>(std::distance(m_keyframes.begin(), itr)), ms);
+}
+
+LaneTransform LaneSpinTrack::Cursor::transformAt(Ms ms)
+{
+    const std::vector<Keyframe> & keyframes = m_track->m_keyframes;
+    if (m_nextIdx > 0 && ms < keyframes[m_nextIdx - 1].startMs)
+    {
+        // Time went backward
+        const auto itr = std::upper_bound(keyframes.begin(), keyframes.end(), ms, [](Ms value, const Keyframe & keyframe) { return value < keyframe.startMs; });
+        m_nextIdx = static_cast<std::size_t>(std::distance(keyframes.begin(), itr));
+    }
+    else
+    {
+        while (m_nextIdx < keyframes.size() && keyframes[m_nextIdx].startMs <= ms)
+        {
+            ++m_nextIdx;
+        }
+    }
+    return m_track->transformAt(m_nextIdx, ms);
+}
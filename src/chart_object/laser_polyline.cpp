@@ -0,0 +1,163 @@
+#include "ksh/chart_object/laser_polyline.hpp"
+
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+
+namespace
+{
+    constexpr double NO_LASER = std::numeric_limits<double>::quiet_NaN();
+    constexpr std::size_t NO_POINT = SIZE_MAX;
+
+    double normalizeLaserX(int x, bool wide)
+    {
+        const double normalized = static_cast<double>(x) / LaserNote::X_MAX;
+        return wide ? normalized * 2 - 0.5 : normalized;
+    }
+
+    // Whether the laser section starting at y is 2x wide
+    bool isWideSection(const ksh::PositionalOptionTracks::Track & laserRanges, Measure y)
+    {
+        const auto itr = std::lower_bound(laserRanges.begin(), laserRanges.end(), y, [](const ksh::PositionalOptionTracks::Point & point, Measure value) { return point.y < value; });
+        return itr != laserRanges.end() && itr->y == y && itr->enumValue<ksh::LaserRange>() == ksh::LaserRange::Wide;
+    }
+}
+
+LaserPolyline::LaserPolyline(const ksh::Lane<LaserNote> & lane, const BeatMap & beatMap, const ksh::PositionalOptionTracks::Track & laserRanges)
+{
+    const auto & tempoChanges = beatMap.tempoChanges();
+
+    const auto addPoint = [this](Ms ms, double x)
+    {
+        // Skip the start point of a laser note that is connected to the previous note
+        if (!m_points.empty() && m_points.back().connectedToNext && m_points.back().ms == ms && m_points.back().x == x)
+        {
+            return;
+        }
+        m_points.push_back(Point{ ms, x, true });
+    };
+
+    Measure prevEndY = 0;
+    bool wide = false;
+    for (const auto & [ y, note ] : lane)
+    {
+        const Measure endY = y + note.length;
+
+        // Gap between lasers
+        if (!m_points.empty() && y != prevEndY)
+        {
+            m_points.back().connectedToNext = false;
+        }
+
+        // The range is kept until the end of the laser section
+        if (m_points.empty() || y != prevEndY)
+        {
+            wide = isWideSection(laserRanges, y);
+        }
+
+        const double startX = normalizeLaserX(note.startX, wide);
+        const double endX = normalizeLaserX(note.endX, wide);
+        const Ms startMs = beatMap.measureToMs(y);
+        if (note.isSlam() && note.startX != note.endX)
+        {
+            // Slam (discontinuity) and the following short straight segment
+            addPoint(startMs, startX);
+            addPoint(startMs, endX);
+        }
+        else
+        {
+            addPoint(startMs, startX);
+
+            // X is linear in measure, so split the segment at tempo changes to keep it linear in ms
+            for (auto itr = tempoChanges.upper_bound(y); itr != tempoChanges.end() && itr->first < endY; ++itr)
+            {
+                const double rate = static_cast<double>(itr->first - y) / note.length;
+                addPoint(beatMap.measureToMs(itr->first), startX + (endX - startX) * rate);
+            }
+        }
+        addPoint(beatMap.measureToMs(endY), endX);
+
+        prevEndY = endY;
+    }
+
+    if (!m_points.empty())
+    {
+        m_points.back().connectedToNext = false;
+    }
+}
+
+std::size_t LaserPolyline::lastPointIdxAt(Ms ms) const
+{
+    auto itr = std::upper_bound(m_points.begin(), m_points.end(), ms, [](Ms value, const Point & point) { return value < point.ms; });
+    if (itr == m_points.begin())
+    {
+        return NO_POINT;
+    }
+    return static_cast<std::size_t>(std::distance(m_points.begin(), itr)) - 1;
+}
+
+double LaserPolyline::interpolate(std::size_t idx, Ms ms) const
+{
+    if (idx == NO_POINT)
+    {
+        return NO_LASER;
+    }
+
+    const Point & point = m_points[idx];
+    if (!point.connectedToNext)
+    {
+        // The end point itself is inclusive
+        return (ms == point.ms) ? point.x : NO_LASER;
+    }
+
+    const Point & nextPoint = m_points[idx + 1];
+    if (nextPoint.ms <= point.ms)
+    {
+        return point.x;
+    }
+    return point.x + (nextPoint.x - point.x) * (ms - point.ms) / (nextPoint.ms - point.ms);
+}
+
+double LaserPolyline::xAt(Ms ms) const
+{
+    return interpolate(lastPointIdxAt(ms), ms);
+}
+
+void LaserPolyline::sample(const Ms * msArray, std::size_t count, double * xArray) const
+{
+    Cursor cursor(*this);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        xArray[i] = cursor.xAt(msArray[i]);
+    }
+}
+
+double LaserPolyline::Cursor::xAt(Ms ms)
+{
+    const std::vector<Point> & points = m_polyline->m_points;
+    if (points.empty())
+    {
+        return NO_LASER;
+    }
+
+    if (ms < points[m_idx].ms)
+    {
+        // Time went backward
+        const std::size_t idx = m_polyline->lastPointIdxAt(ms);
+        if (idx == NO_POINT)
+        {
+            m_idx = 0;
+            return NO_LASER;
+        }
+        m_idx = idx;
+    }
+    else
+    {
+        while (m_idx + 1 < points.size() && points[m_idx + 1].ms <= ms)
+        {
+            ++m_idx;
+        }
+    }
+
+    return m_polyline->interpolate(m_idx, ms);
+}
@@ -0,0 +1,95 @@
+#include "ksh/chart_validator.hpp"
+
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <exception>
+
+#include "ksh/playable_chart.hpp"
+
+namespace ksh
+{
+
+    std::size_t ChartValidationReport::count(DiagnosticSeverity severity) const
+    {
+        return static_cast<std::size_t>(std::count_if(diagnostics.begin(), diagnostics.end(), [severity](const Diagnostic & diagnostic) { return diagnostic.severity == severity; }));
+    }
+
+    ChartValidationReport validateChart(const std::string & chartFilename, std::pmr::memory_resource * resource)
+    {
+        ChartValidationReport report;
+        report.filename = chartFilename;
+
+        std::error_code ec;
+        const auto fileSize = std::filesystem::file_size(chartFilename, ec);
+        if (!ec)
+        {
+            report.fileSize = static_cast<uint64_t>(fileSize);
+        }
+
+        try
+        {
+            const PlayableChart chart(chartFilename, resource);
+            report.diagnostics = chart.diagnostics();
+        }
+        catch (const std::exception & e)
+        {
+            report.diagnostics.push_back(Diagnostic{ DiagnosticSeverity::Error, 0, std::string("Exception while parsing: ") + e.what() });
+        }
+
+        std::stable_sort(report.diagnostics.begin(), report.diagnostics.end(), [](const Diagnostic & a, const Diagnostic & b) { return a.line < b.line; });
+
+        return report;
+    }
+
+    CorpusValidationResult validateCorpus(const std::vector<std::string> & chartFilenames, std::size_t threadCount)
+    {
+        CorpusValidationResult result;
+        result.reports.resize(chartFilenames.size());
+
+        if (threadCount == 0)
+        {
+            threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        threadCount = std::max<std::size_t>(std::min(threadCount, chartFilenames.size()), 1);
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        std::atomic<std::size_t> nextIdx(0);
+        const auto worker = [&]()
+        {
+            // Memory of a chart is reused for the next chart on the same thread
+            std::pmr::unsynchronized_pool_resource pool;
+            for (std::size_t i = nextIdx++; i < chartFilenames.size(); i = nextIdx++)
+            {
+                result.reports[i] = validateChart(chartFilenames[i], &pool);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < threadCount; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto && thread : threads)
+        {
+            thread.join();
+        }
+
+        result.elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        for (const auto & report : result.reports)
+        {
+            result.totalBytes += report.fileSize;
+            if (report.hasError())
+            {
+                ++result.errorFileCount;
+            }
+        }
+
+        return result;
+    }
+
+}
@@ -0,0 +1,116 @@
+#include "ksh/compact_chart.hpp"
+
+#include <map>
+#include <utility>
+#include <limits>
+#include <algorithm>
+
+namespace ksh
+{
+
+    namespace
+    {
+        template <class Note>
+        CompactNote makeCompactNote(Measure y, const Note & note)
+        {
+            CompactNote compactNote;
+            compactNote.y = y;
+            compactNote.length = note.length;
+            compactNote.sidecarIdx = CompactNote::NO_SIDECAR;
+            compactNote.comboCount = static_cast<uint16_t>(std::min<std::size_t>(note.comboCount(), std::numeric_limits<uint16_t>::max()));
+            compactNote.startX = 0;
+            compactNote.endX = 0;
+            return compactNote;
+        }
+    }
+
+    template <class Layout>
+    BasicCompactChart<Layout>::BasicCompactChart(const BasicPlayableChart<Layout> & chart)
+    {
+        for (std::size_t laneIdx = 0; laneIdx < Layout::BT_LANE_COUNT; ++laneIdx)
+        {
+            const auto & lane = chart.btLane(laneIdx);
+            CompactLane & compactLane = m_btLanes[laneIdx];
+            compactLane.reserve(lane.size());
+            for (const auto & [ y, note ] : lane)
+            {
+                compactLane.push_back(makeCompactNote(y, note));
+            }
+        }
+
+        std::map<std::pair<std::string, std::string>, uint32_t> fxAudioEffectIdxs;
+        for (std::size_t laneIdx = 0; laneIdx < Layout::FX_LANE_COUNT; ++laneIdx)
+        {
+            const auto & lane = chart.fxLane(laneIdx);
+            CompactLane & compactLane = m_fxLanes[laneIdx];
+            compactLane.reserve(lane.size());
+            for (const auto & [ y, note ] : lane)
+            {
+                CompactNote compactNote = makeCompactNote(y, note);
+                if (!note.audioEffectStr.empty() || !note.audioEffectParamStr.empty())
+                {
+                    const auto key = std::make_pair(note.audioEffectStr, note.audioEffectParamStr);
+                    auto itr = fxAudioEffectIdxs.find(key);
+                    if (itr == fxAudioEffectIdxs.end())
+                    {
+                        itr = fxAudioEffectIdxs.emplace(key, static_cast<uint32_t>(m_fxAudioEffects.size())).first;
+                        m_fxAudioEffects.push_back(FXAudioEffectPayload{ note.audioEffectStr, note.audioEffectParamStr });
+                    }
+                    compactNote.sidecarIdx = itr->second;
+                }
+                compactLane.push_back(compactNote);
+            }
+        }
+
+        for (std::size_t laneIdx = 0; laneIdx < Layout::LASER_LANE_COUNT; ++laneIdx)
+        {
+            const auto & lane = chart.laserLane(laneIdx);
+            CompactLane & compactLane = m_laserLanes[laneIdx];
+            compactLane.reserve(lane.size());
+            for (const auto & [ y, note ] : lane)
+            {
+                CompactNote compactNote = makeCompactNote(y, note);
+                compactNote.startX = static_cast<int8_t>(note.startX);
+                compactNote.endX = static_cast<int8_t>(note.endX);
+                if (note.laneSpin.isValid())
+                {
+                    compactNote.sidecarIdx = static_cast<uint32_t>(m_laneSpins.size());
+                    m_laneSpins.push_back(note.laneSpin);
+                }
+                compactLane.push_back(compactNote);
+            }
+        }
+    }
+
+    template <class Layout>
+    std::size_t BasicCompactChart<Layout>::comboCount() const
+    {
+        std::size_t sum = 0;
+        for (auto && lane : m_btLanes)
+        {
+            for (auto && note : lane)
+            {
+                sum += note.comboCount;
+            }
+        }
+        for (auto && lane : m_fxLanes)
+        {
+            for (auto && note : lane)
+            {
+                sum += note.comboCount;
+            }
+        }
+        for (auto && lane : m_laserLanes)
+        {
+            for (auto && note : lane)
+            {
+                sum += note.comboCount;
+            }
+        }
+        return sum;
+    }
+
+    template class BasicCompactChart<DefaultLaneLayout>;
+    template class BasicCompactChart<SixBTLaneLayout>;
+
+}
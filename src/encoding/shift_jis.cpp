@@ -0,0 +1,167 @@
+#include "ksh/encoding/shift_jis.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KSH_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ksh
+{
+
+    namespace
+    {
+        constexpr uint16_t SJIS_TO_UNICODE_TABLE[] = {
+#include "shift_jis_table.inc"
+        };
+
+        constexpr unsigned int TRAIL_BYTE_MIN = 0x40;
+        constexpr unsigned int TRAIL_BYTE_MAX = 0xFC;
+        constexpr unsigned int TRAIL_BYTE_COUNT = TRAIL_BYTE_MAX - TRAIL_BYTE_MIN + 1;
+
+        static_assert(sizeof(SJIS_TO_UNICODE_TABLE) / sizeof(SJIS_TO_UNICODE_TABLE[0]) == 60 * TRAIL_BYTE_COUNT, "Unexpected Shift_JIS table size");
+
+        constexpr char32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+        bool isLeadByte(unsigned char c)
+        {
+            return (c >= 0x81 && c <= 0x9F) || (c >= 0xE0 && c <= 0xFC);
+        }
+
+        // Row index in SJIS_TO_UNICODE_TABLE
+        std::size_t leadByteRow(unsigned char c)
+        {
+            return (c <= 0x9F) ? (c - 0x81) : (c - 0xE0 + 0x1F);
+        }
+
+        void appendCodePointAsUTF8(std::string & dest, char32_t codePoint)
+        {
+            if (codePoint < 0x80)
+            {
+                dest.push_back(static_cast<char>(codePoint));
+            }
+            else if (codePoint < 0x800)
+            {
+                const char bytes[2] = {
+                    static_cast<char>(0xC0 | (codePoint >> 6)),
+                    static_cast<char>(0x80 | (codePoint & 0x3F)),
+                };
+                dest.append(bytes, 2);
+            }
+            else
+            {
+                // CP932 only maps to the BMP
+                const char bytes[3] = {
+                    static_cast<char>(0xE0 | (codePoint >> 12)),
+                    static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)),
+                    static_cast<char>(0x80 | (codePoint & 0x3F)),
+                };
+                dest.append(bytes, 3);
+            }
+        }
+    }
+
+    std::size_t asciiPrefixLength(const char * data, std::size_t size)
+    {
+        std::size_t i = 0;
+
+#ifdef KSH_USE_SSE2
+        for (; i + 32 <= size; i += 32)
+        {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 16));
+            if (_mm_movemask_epi8(_mm_or_si128(a, b)) != 0)
+            {
+                break;
+            }
+        }
+        for (; i + 16 <= size; i += 16)
+        {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            if (_mm_movemask_epi8(a) != 0)
+            {
+                break;
+            }
+        }
+#else
+        constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+        for (; i + 16 <= size; i += 16)
+        {
+            uint64_t a, b;
+            std::memcpy(&a, data + i, 8);
+            std::memcpy(&b, data + i + 8, 8);
+            if (((a | b) & HIGH_BITS) != 0)
+            {
+                break;
+            }
+        }
+#endif
+
+        // Remaining bytes (or the block that contains a non-ASCII byte)
+        while (i < size && static_cast<unsigned char>(data[i]) < 0x80)
+        {
+            ++i;
+        }
+
+        return i;
+    }
+
+    void appendShiftJISAsUTF8(std::string & dest, std::string_view shiftJISStr)
+    {
+        const char * data = shiftJISStr.data();
+        const std::size_t size = shiftJISStr.size();
+
+        std::size_t i = 0;
+        while (i < size)
+        {
+            // Copy the ASCII run as is
+            const std::size_t asciiLength = asciiPrefixLength(data + i, size - i);
+            dest.append(data + i, asciiLength);
+            i += asciiLength;
+
+            // Convert the non-ASCII run (a trail byte can be in the ASCII range, so it is consumed with its lead byte)
+            while (i < size && static_cast<unsigned char>(data[i]) >= 0x80)
+            {
+                const unsigned char c = static_cast<unsigned char>(data[i]);
+                if (c >= 0xA1 && c <= 0xDF)
+                {
+                    // Half-width katakana
+                    appendCodePointAsUTF8(dest, 0xFF61 + (c - 0xA1));
+                    ++i;
+                }
+                else if (isLeadByte(c) && i + 1 < size)
+                {
+                    const unsigned char trail = static_cast<unsigned char>(data[i + 1]);
+                    if (trail >= TRAIL_BYTE_MIN && trail <= TRAIL_BYTE_MAX)
+                    {
+                        const char32_t codePoint = SJIS_TO_UNICODE_TABLE[leadByteRow(c) * TRAIL_BYTE_COUNT + (trail - TRAIL_BYTE_MIN)];
+                        appendCodePointAsUTF8(dest, (codePoint != 0) ? codePoint : REPLACEMENT_CHARACTER);
+                        i += 2;
+                    }
+                    else
+                    {
+                        // Broken lead byte (keep the next byte)
+                        appendCodePointAsUTF8(dest, REPLACEMENT_CHARACTER);
+                        ++i;
+                    }
+                }
+                else
+                {
+                    appendCodePointAsUTF8(dest, REPLACEMENT_CHARACTER);
+                    ++i;
+                }
+            }
+        }
+    }
+
+    std::string shiftJISToUTF8(std::string_view shiftJISStr)
+    {
+        std::string dest;
+        dest.reserve(shiftJISStr.size() + shiftJISStr.size() / 2);
+        appendShiftJISAsUTF8(dest, shiftJISStr);
+        return dest;
+    }
+
+}
@@ -0,0 +1,387 @@
+#include "ksh/library_index.hpp"
+
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace ksh
+{
+
+    namespace
+    {
+        constexpr char INDEX_FILE_MAGIC[8] = { 'K', 'S', 'H', 'I', 'N', 'D', 'E', 'X' };
+
+        // Bump this when the entry layout or the derived stats change
+        // (2: modified times from stat and charts with errors are not indexed)
+        constexpr uint32_t INDEX_FILE_VERSION = 2;
+
+        void writeU64(std::ostream & os, uint64_t value)
+        {
+            char bytes[8];
+            for (int i = 0; i < 8; ++i)
+            {
+                bytes[i] = static_cast<char>(value >> (i * 8));
+            }
+            os.write(bytes, sizeof(bytes));
+        }
+
+        void writeDouble(std::ostream & os, double value)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            writeU64(os, bits);
+        }
+
+        void writeString(std::ostream & os, const std::string & str)
+        {
+            writeU64(os, str.size());
+            os.write(str.data(), static_cast<std::streamsize>(str.size()));
+        }
+
+        bool readU64(std::istream & is, uint64_t & value)
+        {
+            unsigned char bytes[8];
+            if (!is.read(reinterpret_cast<char *>(bytes), sizeof(bytes)))
+            {
+                return false;
+            }
+            value = 0;
+            for (int i = 7; i >= 0; --i)
+            {
+                value = (value << 8) | bytes[i];
+            }
+            return true;
+        }
+
+        bool readDouble(std::istream & is, double & value)
+        {
+            uint64_t bits;
+            if (!readU64(is, bits))
+            {
+                return false;
+            }
+            std::memcpy(&value, &bits, sizeof(value));
+            return true;
+        }
+
+        bool readString(std::istream & is, std::string & str)
+        {
+            uint64_t size;
+            if (!readU64(is, size) || size > (1u << 24))
+            {
+                return false;
+            }
+            str.resize(static_cast<std::size_t>(size));
+            return static_cast<bool>(is.read(str.data(), static_cast<std::streamsize>(size)));
+        }
+
+        bool readEntry(std::istream & is, LibraryIndexEntry & entry)
+        {
+            uint64_t modifiedTime, metaDataCount, comboCount;
+            if (!readString(is, entry.filename)
+                || !readU64(is, entry.fileSize)
+                || !readU64(is, modifiedTime)
+                || !readU64(is, metaDataCount))
+            {
+                return false;
+            }
+            entry.modifiedTime = static_cast<int64_t>(modifiedTime);
+
+            for (uint64_t i = 0; i < metaDataCount; ++i)
+            {
+                std::string key, value;
+                if (!readString(is, key) || !readString(is, value))
+                {
+                    return false;
+                }
+                entry.metaData.emplace(std::move(key), std::move(value));
+            }
+
+            if (!readU64(is, comboCount)
+                || !readDouble(is, entry.durationMs)
+                || !readDouble(is, entry.minTempo)
+                || !readDouble(is, entry.maxTempo))
+            {
+                return false;
+            }
+            entry.comboCount = static_cast<std::size_t>(comboCount);
+
+            return true;
+        }
+
+        struct FileStat
+        {
+            std::string filename;
+            uint64_t fileSize;
+            int64_t modifiedTime;
+        };
+
+        // Size and modified time of a regular file with one stat call
+        bool statFile(const std::string & filename, FileStat & stat)
+        {
+#ifdef _WIN32
+            struct _stat64 st;
+            if (_wstat64(std::filesystem::u8path(filename).c_str(), &st) != 0 || (st.st_mode & _S_IFREG) == 0)
+            {
+                return false;
+            }
+            const int64_t modifiedTime = static_cast<int64_t>(st.st_mtime) * 1000000000;
+#else
+            struct stat st;
+            if (::stat(filename.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+            {
+                return false;
+            }
+#ifdef __APPLE__
+            const int64_t modifiedTime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+            const int64_t modifiedTime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+            stat.filename = filename;
+            stat.fileSize = static_cast<uint64_t>(st.st_size);
+            stat.modifiedTime = modifiedTime;
+            return true;
+        }
+
+        template <class Note>
+        Measure laneEndMeasure(const Lane<Note> & lane)
+        {
+            Measure end = 0;
+            for (const auto & [ y, note ] : lane)
+            {
+                end = std::max(end, y + note.length);
+            }
+            return end;
+        }
+    }
+
+    LibraryIndex::LibraryIndex(std::string_view indexFilename)
+    {
+        std::ifstream ifs(std::string(indexFilename), std::ios_base::in | std::ios_base::binary);
+        if (!ifs)
+        {
+            return;
+        }
+
+        char magic[sizeof(INDEX_FILE_MAGIC)];
+        uint64_t version, entryCount;
+        if (!ifs.read(magic, sizeof(magic))
+            || std::memcmp(magic, INDEX_FILE_MAGIC, sizeof(magic)) != 0
+            || !readU64(ifs, version)
+            || version != INDEX_FILE_VERSION
+            || !readU64(ifs, entryCount))
+        {
+            return;
+        }
+
+        for (uint64_t i = 0; i < entryCount; ++i)
+        {
+            LibraryIndexEntry entry;
+            if (!readEntry(ifs, entry))
+            {
+                // Broken index file
+                m_entries.clear();
+                return;
+            }
+            std::string filename = entry.filename;
+            m_entries.emplace(std::move(filename), std::move(entry));
+        }
+    }
+
+    bool LibraryIndex::save(std::string_view indexFilename) const
+    {
+        // Write to a temporary file first so that a crash does not leave a broken index
+        const std::string filename(indexFilename);
+        const std::string tmpFilename = filename + ".tmp";
+        {
+            std::ofstream ofs(tmpFilename, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+            if (!ofs)
+            {
+                return false;
+            }
+
+            ofs.write(INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC));
+            writeU64(ofs, INDEX_FILE_VERSION);
+            writeU64(ofs, m_entries.size());
+            for (const auto & [ key, entry ] : m_entries)
+            {
+                writeString(ofs, entry.filename);
+                writeU64(ofs, entry.fileSize);
+                writeU64(ofs, static_cast<uint64_t>(entry.modifiedTime));
+                writeU64(ofs, entry.metaData.size());
+                for (const auto & [ metaKey, metaValue ] : entry.metaData)
+                {
+                    writeString(ofs, metaKey);
+                    writeString(ofs, metaValue);
+                }
+                writeU64(ofs, entry.comboCount);
+                writeDouble(ofs, entry.durationMs);
+                writeDouble(ofs, entry.minTempo);
+                writeDouble(ofs, entry.maxTempo);
+            }
+
+            if (!ofs.flush())
+            {
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmpFilename, filename, ec);
+        return !ec;
+    }
+
+    LibraryIndex::RefreshResult LibraryIndex::refresh(const std::vector<std::string> & chartFilenames, std::size_t threadCount)
+    {
+        RefreshResult result;
+
+        // Find the charts that are new or modified
+        std::unordered_map<std::string, LibraryIndexEntry> entries;
+        std::vector<FileStat> modifiedFiles;
+        for (const auto & filename : chartFilenames)
+        {
+            FileStat stat;
+            if (!statFile(filename, stat))
+            {
+                result.failedFilenames.push_back(filename);
+                continue;
+            }
+
+            auto itr = m_entries.find(filename);
+            if (itr != m_entries.end() && itr->second.fileSize == stat.fileSize && itr->second.modifiedTime == stat.modifiedTime)
+            {
+                entries.insert(m_entries.extract(itr));
+                ++result.reusedCount;
+            }
+            else
+            {
+                modifiedFiles.push_back(std::move(stat));
+            }
+        }
+        result.removedCount = m_entries.size();
+
+        // Parse the modified charts in parallel
+        std::vector<LibraryIndexEntry> newEntries(modifiedFiles.size());
+        std::vector<char> succeeded(modifiedFiles.size(), false);
+        if (threadCount == 0)
+        {
+            threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        threadCount = std::min(threadCount, modifiedFiles.size());
+
+        std::atomic<std::size_t> nextIdx(0);
+        const auto worker = [&]()
+        {
+            for (std::size_t i = nextIdx++; i < modifiedFiles.size(); i = nextIdx++)
+            {
+                try
+                {
+                    succeeded[i] = createEntry(modifiedFiles[i].filename, modifiedFiles[i].fileSize, modifiedFiles[i].modifiedTime, newEntries[i]);
+                }
+                catch (const std::exception &)
+                {
+                    succeeded[i] = false;
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < threadCount; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto && thread : threads)
+        {
+            thread.join();
+        }
+
+        for (std::size_t i = 0; i < newEntries.size(); ++i)
+        {
+            if (succeeded[i])
+            {
+                entries.emplace(modifiedFiles[i].filename, std::move(newEntries[i]));
+                ++result.parsedCount;
+            }
+            else
+            {
+                result.failedFilenames.push_back(modifiedFiles[i].filename);
+            }
+        }
+
+        m_entries = std::move(entries);
+
+        return result;
+    }
+
+    LibraryIndex::RefreshResult LibraryIndex::refreshDirectory(std::string_view directoryPath, std::size_t threadCount)
+    {
+        std::vector<std::string> chartFilenames;
+        std::error_code ec;
+        for (auto itr = std::filesystem::recursive_directory_iterator(directoryPath, ec); !ec && itr != std::filesystem::recursive_directory_iterator(); itr.increment(ec))
+        {
+            if (itr->path().extension() == ".ksh" && itr->is_regular_file(ec))
+            {
+                chartFilenames.push_back(itr->path().string());
+            }
+        }
+        std::sort(chartFilenames.begin(), chartFilenames.end());
+
+        return refresh(chartFilenames, threadCount);
+    }
+
+    const LibraryIndexEntry * LibraryIndex::find(const std::string & chartFilename) const
+    {
+        auto itr = m_entries.find(chartFilename);
+        return (itr == m_entries.end()) ? nullptr : &itr->second;
+    }
+
+    bool LibraryIndex::createEntry(const std::string & chartFilename, uint64_t fileSize, int64_t modifiedTime, LibraryIndexEntry & entry)
+    {
+        const PlayableChart chart(chartFilename);
+        if (hasError(chart.diagnostics()))
+        {
+            // Not indexed, so that the chart is parsed again by the next refresh()
+            return false;
+        }
+
+        entry = LibraryIndexEntry();
+        entry.filename = chartFilename;
+        entry.fileSize = fileSize;
+        entry.modifiedTime = modifiedTime;
+        for (const auto & [ key, value ] : chart.metaData)
+        {
+            entry.metaData.emplace(key, value);
+        }
+        entry.comboCount = chart.comboCount();
+
+        Measure endMeasure = 0;
+        for (const auto & lane : chart.btLanes())
+        {
+            endMeasure = std::max(endMeasure, laneEndMeasure(lane));
+        }
+        for (const auto & lane : chart.fxLanes())
+        {
+            endMeasure = std::max(endMeasure, laneEndMeasure(lane));
+        }
+        for (const auto & lane : chart.laserLanes())
+        {
+            endMeasure = std::max(endMeasure, laneEndMeasure(lane));
+        }
+        entry.durationMs = chart.beatMap().measureToMs(endMeasure);
+
+        const auto & tempoChanges = chart.beatMap().tempoChanges();
+        const auto [ minItr, maxItr ] = std::minmax_element(tempoChanges.begin(), tempoChanges.end(),
+            [](const auto & a, const auto & b) { return a.second < b.second; });
+        entry.minTempo = minItr->second;
+        entry.maxTempo = maxItr->second;
+
+        return true;
+    }
+
+}
@@ -0,0 +1,157 @@
+#include "ksh/line_tokenizer.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KSH_USE_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace ksh
+{
+
+    namespace
+    {
+        // Classify a line whose "|"/"=" existence is already known
+        // (same priority as the body parser: comment > definition > chart > option > bar line)
+        LineKind classifyLine(const char * line, std::size_t length, bool hasBlockSeparator, bool hasOptionSeparator)
+        {
+            if (length >= 1 && line[0] == ';')
+            {
+                return LineKind::Comment;
+            }
+            if (length >= 2 && line[0] == '/' && line[1] == '/')
+            {
+                return LineKind::Comment;
+            }
+            if (length >= 1 && line[0] == '#')
+            {
+                return LineKind::Definition;
+            }
+            if (hasBlockSeparator)
+            {
+                return LineKind::Chart;
+            }
+            if (hasOptionSeparator)
+            {
+                return LineKind::Option;
+            }
+            if (length == 2 && line[0] == '-' && line[1] == '-')
+            {
+                return LineKind::BarLine;
+            }
+            return LineKind::Other;
+        }
+
+        void addLine(std::string_view buffer, std::size_t lineStart, std::size_t lineEnd, bool hasBlockSeparator, bool hasOptionSeparator, std::vector<TokenizedLine> & lines)
+        {
+            // Eliminate CR
+            if (lineEnd > lineStart && buffer[lineEnd - 1] == '\r')
+            {
+                --lineEnd;
+            }
+
+            const std::size_t length = lineEnd - lineStart;
+            lines.push_back(TokenizedLine{
+                static_cast<uint32_t>(lineStart),
+                static_cast<uint32_t>(length),
+                classifyLine(buffer.data() + lineStart, length, hasBlockSeparator, hasOptionSeparator),
+            });
+        }
+
+#ifdef KSH_USE_SSE2
+        int countTrailingZeros(uint32_t mask)
+        {
+#ifdef _MSC_VER
+            unsigned long idx;
+            _BitScanForward(&idx, mask);
+            return static_cast<int>(idx);
+#else
+            return __builtin_ctz(mask);
+#endif
+        }
+#endif
+    }
+
+    void tokenizeLines(std::string_view buffer, std::vector<TokenizedLine> & lines)
+    {
+        const char * data = buffer.data();
+        const std::size_t size = buffer.size();
+
+        std::size_t lineStart = 0;
+        bool hasBlockSeparator = false;
+        bool hasOptionSeparator = false;
+        std::size_t i = 0;
+
+#ifdef KSH_USE_SSE2
+        const __m128i newLineChars = _mm_set1_epi8('\n');
+        const __m128i blockSeparatorChars = _mm_set1_epi8('|');
+        const __m128i optionSeparatorChars = _mm_set1_epi8('=');
+        for (; i + 16 <= size; i += 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            uint32_t newLineMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newLineChars)));
+            const uint32_t blockSeparatorMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, blockSeparatorChars)));
+            const uint32_t optionSeparatorMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, optionSeparatorChars)));
+
+            // Bits of this block that belong to the current line
+            uint32_t currentLineMask = 0xFFFF;
+            while (newLineMask != 0)
+            {
+                const int pos = countTrailingZeros(newLineMask);
+                const uint32_t beforeNewLineMask = currentLineMask & ((1u << pos) - 1);
+                hasBlockSeparator = hasBlockSeparator || (blockSeparatorMask & beforeNewLineMask) != 0;
+                hasOptionSeparator = hasOptionSeparator || (optionSeparatorMask & beforeNewLineMask) != 0;
+
+                addLine(buffer, lineStart, i + pos, hasBlockSeparator, hasOptionSeparator, lines);
+                lineStart = i + pos + 1;
+                hasBlockSeparator = false;
+                hasOptionSeparator = false;
+
+                currentLineMask = 0xFFFF & ~((2u << pos) - 1);
+                newLineMask &= newLineMask - 1;
+            }
+            hasBlockSeparator = hasBlockSeparator || (blockSeparatorMask & currentLineMask) != 0;
+            hasOptionSeparator = hasOptionSeparator || (optionSeparatorMask & currentLineMask) != 0;
+        }
+#endif
+
+        // Remaining bytes
+        for (; i < size; ++i)
+        {
+            switch (data[i])
+            {
+            case '\n':
+                addLine(buffer, lineStart, i, hasBlockSeparator, hasOptionSeparator, lines);
+                lineStart = i + 1;
+                hasBlockSeparator = false;
+                hasOptionSeparator = false;
+                break;
+            case '|':
+                hasBlockSeparator = true;
+                break;
+            case '=':
+                hasOptionSeparator = true;
+                break;
+            default:
+                break;
+            }
+        }
+
+        // Last line without LF
+        if (lineStart < size)
+        {
+            addLine(buffer, lineStart, size, hasBlockSeparator, hasOptionSeparator, lines);
+        }
+    }
+
+    std::vector<TokenizedLine> tokenizeLines(std::string_view buffer)
+    {
+        std::vector<TokenizedLine> lines;
+        lines.reserve(buffer.size() / 8); // Chart lines are typically 10-12 bytes
+        tokenizeLines(buffer, lines);
+        return lines;
+    }
+
+}
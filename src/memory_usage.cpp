@@ -0,0 +1,16 @@
+#include "ksh/memory_usage.hpp"
+
+#include <algorithm>
+
+namespace ksh
+{
+
+    std::size_t heapBlockBytes(std::size_t requestedBytes)
+    {
+        // Chunk header (one size_t) + alignment to two size_t, with the minimum chunk size of four size_t
+        constexpr std::size_t alignment = sizeof(std::size_t) * 2;
+        constexpr std::size_t minBytes = sizeof(std::size_t) * 4;
+        return std::max(minBytes, (requestedBytes + sizeof(std::size_t) + alignment - 1) / alignment * alignment);
+    }
+
+}
@@ -6,6 +6,7 @@ namespace ksh
     AbstractNoteBuilder::AbstractNoteBuilder()
         : m_preparedNotePos(0)
         , m_preparedNoteLength(0)
+        , m_preparedNoteHalvesCombo(false)
         , m_notePrepared(false)
     {
     }
@@ -73,6 +74,7 @@ namespace ksh
             m_preparedNoteLength = 0;
             m_preparedNoteHalvesCombo = halvesCombo;
             m_preparedNoteAudioEffectStr = audioEffectStr;
+            m_preparedNoteAudioEffectParamStr = audioEffectParamStr;
         }
     }
 
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdlib>
+
+// Number parsing shared by the parsers in src/ (not installed)
+
+namespace ksh
+{
+
+    // Parse a number like std::stod() but without exceptions (returns false if str does not start with a number)
+    inline bool parseDouble(const char * str, double & value)
+    {
+        char * end;
+        value = std::strtod(str, &end);
+        return end != str;
+    }
+
+}
@@ -1,22 +1,24 @@
 #include "ksh/playable_chart.hpp"
 
 #include <cmath>
+#include <filesystem>
+#include <algorithm>
+#include <utility>
 #include <cstddef>
 #include <cstdint>
-#include <cassert>
+#include <cstdlib>
 
+#include "ksh/option_key.hpp"
 #include "ksh/note_builder.hpp"
+#include "ksh/line_tokenizer.hpp"
+#include "ksh/encoding/shift_jis.hpp"
+#include "parse_number.hpp"
 
 namespace ksh
 {
 
     constexpr unsigned char OPTION_SEPARATOR = '=';
     constexpr unsigned char BLOCK_SEPARATOR = '|';
-    const std::string MEASURE_SEPARATOR = "--";
-
-    constexpr std::size_t BLOCK_BT = 0;
-    constexpr std::size_t BLOCK_FX = 1;
-    constexpr std::size_t BLOCK_LASER = 2;
 
     // Maximum value of zoom
     constexpr double ZOOM_ABS_MAX_LEGACY = 300.0; // ver <  1.67
@@ -30,106 +32,234 @@ namespace ksh
     constexpr double CENTER_SPLIT_ABS_MAX = 65535.0;
     constexpr double MANUAL_TILT_ABS_MAX = 1000.0;
 
-    bool isChartLine(const std::string & line)
+    namespace
     {
-        return line.find(BLOCK_SEPARATOR) != std::string::npos;
-    }
+        std::pair<std::string, std::string> splitOptionLine(std::string_view optionLine)
+        {
+            // (option lines always have "=" because the tokenizer classifies lines by it; otherwise the value is empty)
+            const std::size_t equalIdx = std::min(optionLine.find_first_of(OPTION_SEPARATOR), optionLine.size());
 
-    bool isOptionLine(const std::string & line)
-    {
-        return line.find(OPTION_SEPARATOR) != std::string::npos;
-    }
+            return std::pair<std::string, std::string>(
+                optionLine.substr(0, equalIdx),
+                optionLine.substr(std::min(equalIdx + 1, optionLine.size()))
+            );
+        }
 
-    bool isBarLine(const std::string & line)
-    {
-        return line == MEASURE_SEPARATOR;
-    }
+        constexpr bool halvesCombo(double tempo)
+        {
+            return tempo >= 256.0;
+        }
 
-    std::pair<std::string, std::string> splitOptionLine(const std::string & optionLine)
-    {
-        std::size_t equalIdx = optionLine.find_first_of(OPTION_SEPARATOR);
+        std::string kshLegacyFXCharToAudioEffect(unsigned char c)
+        {
+            switch (c)
+            {
+            case 'S': return "Retrigger;8";
+            case 'V': return "Retrigger;12";
+            case 'T': return "Retrigger;16";
+            case 'W': return "Retrigger;24";
+            case 'U': return "Retrigger;32";
+            case 'G': return "Gate;4";
+            case 'H': return "Gate;8";
+            case 'K': return "Gate;12";
+            case 'I': return "Gate;16";
+            case 'L': return "Gate;24";
+            case 'J': return "Gate;32";
+            case 'F': return "Flanger";
+            case 'P': return "PitchShift;12";
+            case 'B': return "BitCrusher;5";
+            case 'Q': return "Phaser";
+            case 'X': return "Wobble;12";
+            case 'A': return "TapeStop;17";
+            case 'D': return "SideChain";
+            default:  return "";
+            }
+        }
 
-        // Option line should have "="
-        assert(equalIdx != std::string::npos);
+        bool isManualTiltValue(const std::string & value)
+        {
+            return !value.empty() && ((value[0] >= '0' && value[0] <= '9') || value[0] == '-');
+        }
 
-        return std::pair<std::string, std::string>(
-            optionLine.substr(0, equalIdx),
-            optionLine.substr(equalIdx + 1)
-        );
-    }
+        // Tempo value of "t=" (tempo ranges like "120-240" in the header are parsed as the first value)
+        bool parseTempo(const std::string & value, double & tempo)
+        {
+            return parseDouble(value.c_str(), tempo) && tempo > 0.0;
+        }
 
-    constexpr bool halvesCombo(double tempo)
-    {
-        return tempo >= 256.0;
-    }
+        // Returns false if the value is a tempo range or invalid
+        bool insertTempoChange(std::map<Measure, double> & tempoChanges, Measure y, const std::string & value)
+        {
+            double tempo;
+            if (!parseTempo(value, tempo))
+            {
+                return false;
+            }
 
-    std::string kshLegacyFXCharToAudioEffect(unsigned char c)
-    {
-        switch (c)
-        {
-        case 'S': return "Retrigger;8";
-        case 'V': return "Retrigger;12";
-        case 'T': return "Retrigger;16";
-        case 'W': return "Retrigger;24";
-        case 'U': return "Retrigger;32";
-        case 'G': return "Gate;4";
-        case 'H': return "Gate;8";
-        case 'K': return "Gate;12";
-        case 'I': return "Gate;16";
-        case 'L': return "Gate;24";
-        case 'J': return "Gate;32";
-        case 'F': return "Flanger";
-        case 'P': return "PitchShift;12";
-        case 'B': return "BitCrusher;5";
-        case 'Q': return "Phaser";
-        case 'X': return "Wobble;12";
-        case 'A': return "TapeStop;17";
-        case 'D': return "SideChain";
-        default:  return "";
+            if (tempoChanges.count(y))
+            {
+                tempoChanges[y] = tempo;
+                return true;
+            }
+            else if (value.find('-') == std::string::npos)
+            {
+                tempoChanges.emplace(y, tempo);
+                return true;
+            }
+            else
+            {
+                return false;
+            }
         }
-    }
 
-    bool isManualTiltValue(const std::string & value)
-    {
-        return !value.empty() && ((value[0] >= '0' && value[0] <= '9') || value[0] == '-');
-    }
-
-    bool PlayableChart::insertTempoChange(std::map<Measure, double> & tempoChanges, Measure y, const std::string & value)
-    {
-        if (tempoChanges.count(y))
+        // Returns false if str is not "<numerator>/<denominator>" with positive numbers
+        bool parseTimeSig(const std::string & str, TimeSig & timeSig)
         {
-            tempoChanges[y] = std::stod(value);
+            const std::size_t slashIdx = str.find('/');
+            if (slashIdx == std::string::npos)
+            {
+                return false;
+            }
+
+            const char * numeratorBegin = str.c_str();
+            const char * denominatorBegin = numeratorBegin + slashIdx + 1;
+            char * numeratorEnd;
+            char * denominatorEnd;
+            const long numerator = std::strtol(numeratorBegin, &numeratorEnd, 10);
+            const long denominator = std::strtol(denominatorBegin, &denominatorEnd, 10);
+            if (numeratorEnd == numeratorBegin || denominatorEnd == denominatorBegin || numerator <= 0 || denominator <= 0)
+            {
+                return false;
+            }
+
+            timeSig = TimeSig{ static_cast<uint32_t>(numerator), static_cast<uint32_t>(denominator) };
             return true;
         }
-        else if (value.find('-') == std::string::npos)
+
+        struct ChartLineBlocks
         {
-            tempoChanges.emplace(y, std::stod(value));
-            return true;
+            std::string_view bt;
+            std::string_view fx;
+            std::string_view laser; // Laser notes and lane spin
+        };
+
+        ChartLineBlocks splitChartLine(std::string_view line)
+        {
+            ChartLineBlocks blocks;
+            const std::size_t firstSeparatorIdx = line.find(BLOCK_SEPARATOR);
+            blocks.bt = line.substr(0, firstSeparatorIdx);
+            if (firstSeparatorIdx != std::string_view::npos)
+            {
+                const std::size_t secondSeparatorIdx = line.find(BLOCK_SEPARATOR, firstSeparatorIdx + 1);
+                blocks.fx = line.substr(firstSeparatorIdx + 1, secondSeparatorIdx - firstSeparatorIdx - 1);
+                if (secondSeparatorIdx != std::string_view::npos)
+                {
+                    blocks.laser = line.substr(secondSeparatorIdx + 1);
+                }
+            }
+            return blocks;
         }
-        else
+
+        // Call func(laneIdx, c) for each lane character in a block (extra characters are ignored)
+        template <std::size_t LaneCount, typename Func>
+        void forEachLaneChar(std::string_view block, Func && func)
         {
-            return false;
+            if (block.size() >= LaneCount)
+            {
+                // Fixed trip count so that the loop can be unrolled
+                for (std::size_t laneIdx = 0; laneIdx < LaneCount; ++laneIdx)
+                {
+                    func(laneIdx, block[laneIdx]);
+                }
+            }
+            else
+            {
+                for (std::size_t laneIdx = 0; laneIdx < block.size(); ++laneIdx)
+                {
+                    func(laneIdx, block[laneIdx]);
+                }
+            }
+        }
+
+        template <class Builder, class Lanes, std::size_t... LaneIdxs>
+        std::array<Builder, sizeof...(LaneIdxs)> makeNoteBuilders(Lanes & lanes, std::index_sequence<LaneIdxs...>)
+        {
+            return { Builder(lanes[LaneIdxs])... };
+        }
+
+        template <class Lanes, std::size_t... LaneIdxs>
+        Lanes makeLanes(std::pmr::memory_resource * resource, std::index_sequence<LaneIdxs...>)
+        {
+            return { typename Lanes::value_type((static_cast<void>(LaneIdxs), resource))... };
         }
     }
 
-    TimeSig parseTimeSig(const std::string & str)
+    template <class Layout>
+    BasicPlayableChart<Layout>::BasicPlayableChart(std::string_view filename, bool isEditor, BodyLoadPolicy bodyLoadPolicy, std::pmr::memory_resource * resource)
+        : Chart(filename, bodyLoadPolicy == BodyLoadPolicy::Immediate, resource)
+        , m_isEditor(isEditor)
+        , m_resource(resource)
+        , m_bodyLoadState(std::make_unique<BodyLoadState>())
+        , m_btLanes(makeLanes<BTLanes>(resource, std::make_index_sequence<Layout::BT_LANE_COUNT>()))
+        , m_fxLanes(makeLanes<FXLanes>(resource, std::make_index_sequence<Layout::FX_LANE_COUNT>()))
+        , m_laserLanes(makeLanes<LaserLanes>(resource, std::make_index_sequence<Layout::LASER_LANE_COUNT>()))
+        , m_zoomTop(resource)
+        , m_zoomBottom(resource)
+        , m_zoomSide(resource)
+        , m_centerSplit(resource)
+        , m_manualTilt(resource)
+        , m_positionalOptions(resource)
     {
-        std::size_t slashIdx = str.find('/');
-        assert(slashIdx != std::string::npos);
+        if (bodyLoadPolicy == BodyLoadPolicy::Immediate)
+        {
+            loadBody();
+        }
+    }
 
-        return TimeSig{
-            static_cast<uint32_t>(std::stoi(str.substr(0, slashIdx))),
-            static_cast<uint32_t>(std::stoi(str.substr(slashIdx + 1)))
-        };
+    template <class Layout>
+    std::future<void> BasicPlayableChart<Layout>::loadBodyAsync() const
+    {
+        return std::async(std::launch::async, [this]() { loadBody(); });
     }
 
-    PlayableChart::PlayableChart(std::string_view filename, bool isEditor)
-        : Chart(filename, true)
-        , m_btLanes(4)
-        , m_fxLanes(2)
-        , m_laserLanes(2)
+    template <class Layout>
+    void BasicPlayableChart<Layout>::parseBody() const
     {
-        // TODO: Catch exceptions from std::stod()
+        // Malformed lines are reported to m_diagnostics and skipped (or parsed with a fallback value)
+
+        // The body stays empty with the default beat map if the file cannot be read
+        const auto setEmptyBody = [this]()
+        {
+            m_beatMap = std::make_shared<const BeatMap>(std::map<Measure, double>{ { 0, 120.0 } }, std::map<int, TimeSig>{ { 0, TimeSig{ 4, 4 } } }, m_resource);
+        };
+
+        // Nothing to parse (already reported by Chart)
+        if (m_fileOpenFailed)
+        {
+            setEmptyBody();
+            return;
+        }
+
+        // Reopen the file if the header has been read with BodyLoadPolicy::OnDemand
+        // (the file may have been removed or truncated after the header was read)
+        if (!m_ifs->is_open() && m_bodyPos >= 0)
+        {
+            m_ifs->open(m_filename, std::ifstream::in);
+            if (m_ifs->is_open())
+            {
+                m_ifs->seekg(m_bodyPos);
+            }
+
+            std::error_code ec;
+            const auto fileSize = std::filesystem::file_size(m_filename, ec);
+            if (!m_ifs->is_open() || !*m_ifs || ec || fileSize < static_cast<std::uintmax_t>(static_cast<std::streamoff>(m_bodyPos)))
+            {
+                addDiagnostic(DiagnosticSeverity::Error, 0, "Failed to reopen the file to load the body");
+                m_ifs->close();
+                setEmptyBody();
+                return;
+            }
+        }
 
         // For backward compatibility of zoom_top/zoom_bottom/zoom_side
         const double zoomAbsMax = isKshVersionNewerThanOrEqualTo(167) ? ZOOM_ABS_MAX : ZOOM_ABS_MAX_LEGACY;
@@ -139,292 +269,389 @@ namespace ksh
         std::map<int, TimeSig> timeSigChanges;
 
         // Note builders for note insertion to lanes
-        std::vector<BTNoteBuilder> btNoteBuilders;
-        for (auto && lane : m_btLanes)
-        {
-            btNoteBuilders.emplace_back(lane);
-        }
-        std::vector<FXNoteBuilder> fxNoteBuilders;
-        for (auto && lane : m_fxLanes)
-        {
-            fxNoteBuilders.emplace_back(lane);
-        }
-        std::vector<LaserNoteBuilder> laserNoteBuilders;
-        for (auto && lane : m_laserLanes)
-        {
-            laserNoteBuilders.emplace_back(lane);
-        }
+        auto btNoteBuilders = makeNoteBuilders<BTNoteBuilder>(m_btLanes, std::make_index_sequence<Layout::BT_LANE_COUNT>());
+        auto fxNoteBuilders = makeNoteBuilders<FXNoteBuilder>(m_fxLanes, std::make_index_sequence<Layout::FX_LANE_COUNT>());
+        auto laserNoteBuilders = makeNoteBuilders<LaserNoteBuilder>(m_laserLanes, std::make_index_sequence<Layout::LASER_LANE_COUNT>());
 
         // FX audio effect string ("fx-l=" or "fx-r=" in .ksh)
-        std::vector<std::string> currentFXAudioEffectStrs(m_fxLanes.size());
+        std::array<std::string, Layout::FX_LANE_COUNT> currentFXAudioEffectStrs;
 
         // FX audio effect parameters ("fx-l_param1=" or "fx-r_param1=" in .ksh; currently no "param2")
-        std::vector<std::string> currentFXAudioEffectParamStrs(m_fxLanes.size());
+        std::array<std::string, Layout::FX_LANE_COUNT> currentFXAudioEffectParamStrs;
 
         // Insert the first tempo change
         double currentTempo = 120.0;
         if (metaData.count("t"))
         {
-            if (insertTempoChange(tempoChanges, 0, metaData.at("t")))
+            const std::string value(metaData.at("t"));
+            if (insertTempoChange(tempoChanges, 0, value))
             {
                 currentTempo = tempoChanges.at(0);
             }
+            else if (double tempo; !parseTempo(value, tempo))
+            {
+                addDiagnostic(DiagnosticSeverity::Warning, 0, "Invalid tempo in the header \"t=" + value + "\"");
+            }
         }
 
         // Insert the first time signature change
         uint32_t currentNumerator = 4;
         uint32_t currentDenominator = 4;
-        if (metaData.count("beat"))
+        TimeSig headerTimeSig;
+        if (metaData.count("beat") && parseTimeSig(std::string(metaData.at("beat")), headerTimeSig))
         {
-            TimeSig timeSig = parseTimeSig(metaData.at("beat"));
             timeSigChanges.emplace(
                 0,
-                timeSig
+                headerTimeSig
             );
-            currentNumerator = timeSig.numerator;
-            currentDenominator = timeSig.denominator;
+            currentNumerator = headerTimeSig.numerator;
+            currentDenominator = headerTimeSig.denominator;
         }
         else
         {
+            if (metaData.count("beat"))
+            {
+                addDiagnostic(DiagnosticSeverity::Warning, 0, "Invalid time signature in the header \"beat=" + std::string(metaData.at("beat")) + "\"");
+            }
             timeSigChanges[0] = { 4, 4 };
         }
 
         // Buffers
         // (needed because actual addition cannot come before the measure value calculation)
-        std::vector<std::string> chartLines;
-        using OptionLine = std::pair<std::size_t, std::pair<std::string, std::string>>; // first = line index of chart lines
+        std::vector<std::string_view> chartLines;
+        struct OptionLine
+        {
+            std::size_t lineIdx; // Line index of chart lines
+            std::size_t lineNumber; // Line number in the file (for diagnostics)
+            OptionKey optionKey;
+            std::string key;
+            std::string value;
+        };
         std::vector<OptionLine> optionLines;
 
+        // Values of a positional option (inserted if not exists)
+        const auto positionalOptionValues = [this](const std::string & key) -> std::pmr::map<Measure, std::pmr::string> &
+        {
+            return m_positionalOptions[std::pmr::string(key, m_resource)];
+        };
+
         Measure currentMeasure = 0;
         int measureCount = 0;
 
-        // Read chart body
+        // Read chart body at once
         // Expect m_ifs to start from the next of the first bar line ("--")
-        std::string line;
-        while (std::getline(*m_ifs, line, '\n'))
+        std::string body;
         {
-            // Eliminate CR
-            if(!line.empty() && *line.crbegin() == '\r') {
-                line.pop_back();
-            }
-
-            // Skip comments
-            if (line[0] == ';' || line.substr(0, 2) == "//")
+            const std::streampos bodyPos = m_ifs->tellg();
+            m_ifs->seekg(0, std::ios_base::end);
+            const std::streampos endPos = m_ifs->tellg();
+            m_ifs->seekg(bodyPos);
+            if (bodyPos >= 0 && endPos > bodyPos)
             {
-                continue;
+                body.resize(static_cast<std::size_t>(endPos - bodyPos));
+                m_ifs->read(body.data(), static_cast<std::streamsize>(body.size()));
+                body.resize(static_cast<std::size_t>(m_ifs->gcount())); // Can be shorter in text mode
             }
+        }
 
-            // TODO: Read user-defined audio effects
-            if (line[0] == '#')
-            {
-                continue;
-            }
+        // Convert Shift_JIS to UTF-8
+        // (needs to be before tokenization because a trail byte can be "|")
+        if (!isUTF8() && !isASCII(body))
+        {
+            body = shiftJISToUTF8(body);
+        }
 
-            if (isChartLine(line))
+        // Split into lines
+        const std::vector<TokenizedLine> lines = tokenizeLines(body);
+
+        for (std::size_t lineIdx = 0; lineIdx < lines.size(); ++lineIdx)
+        {
+            const TokenizedLine & tokenizedLine = lines[lineIdx];
+            const std::string_view line = tokenizedLine.view(body);
+            const std::size_t lineNumber = m_bodyLineNumber + lineIdx;
+
+            // Comments are skipped here
+            if (tokenizedLine.kind == LineKind::Chart)
             {
                 chartLines.push_back(line);
+
+                // Missing lanes are regarded as empty
+                const ChartLineBlocks blocks = splitChartLine(line);
+                if (blocks.bt.size() < Layout::BT_LANE_COUNT || blocks.fx.size() < Layout::FX_LANE_COUNT || blocks.laser.size() < Layout::LASER_LANE_COUNT)
+                {
+                    addDiagnostic(DiagnosticSeverity::Warning, lineNumber, "Chart line has fewer lanes than expected \"" + std::string(line) + "\"");
+                }
+                else if (blocks.laser.size() > Layout::LASER_LANE_COUNT && !LaneSpin(std::string(blocks.laser.substr(Layout::LASER_LANE_COUNT))).isValid())
+                {
+                    addDiagnostic(DiagnosticSeverity::Warning, lineNumber, "Invalid lane spin \"" + std::string(blocks.laser.substr(Layout::LASER_LANE_COUNT)) + "\"");
+                }
             }
-            else if (isOptionLine(line))
+            else if (tokenizedLine.kind == LineKind::Definition)
+            {
+                // User-defined audio effects (resolved after all lines are read because they can be defined after use)
+                m_audioEffects.addDefinitionLine(line);
+            }
+            else if (tokenizedLine.kind == LineKind::Option)
             {
                 auto [ key, value ] = splitOptionLine(line);
-                if (key == "t")
+                const OptionKey optionKey = toOptionKey(key);
+                switch (optionKey)
                 {
+                case OptionKey::Tempo:
+                {
+                    double tempo;
+                    if (!parseTempo(value, tempo))
+                    {
+                        addDiagnostic(DiagnosticSeverity::Warning, lineNumber, "Invalid tempo \"" + std::string(line) + "\"");
+                        break;
+                    }
                     if (value.find('-') == std::string::npos)
                     {
-                        currentTempo = std::stod(value);
+                        currentTempo = tempo;
                     }
-                    optionLines.emplace_back(chartLines.size(), std::make_pair(key, value));
+                    optionLines.push_back({ chartLines.size(), lineNumber, optionKey, std::move(key), std::move(value) });
+                    break;
                 }
-                else if (key == "beat")
+
+                case OptionKey::Beat:
                 {
-                    TimeSig timeSig = parseTimeSig(value);
+                    TimeSig timeSig;
+                    if (!parseTimeSig(value, timeSig))
+                    {
+                        addDiagnostic(DiagnosticSeverity::Warning, lineNumber, "Invalid time signature \"" + std::string(line) + "\"");
+                        break;
+                    }
                     timeSigChanges.emplace(
                         measureCount,
                         timeSig
                     );
                     currentNumerator = timeSig.numerator;
                     currentDenominator = timeSig.denominator;
+                    break;
                 }
-                else if (key == "fx-l")
-                {
+
+                case OptionKey::FXL:
                     currentFXAudioEffectStrs[0] = value;
-                }
-                else if (key == "fx-r")
-                {
+                    break;
+
+                case OptionKey::FXR:
                     currentFXAudioEffectStrs[1] = value;
-                }
-                else if (key == "fx-l_param1")
-                {
+                    break;
+
+                case OptionKey::FXLParam1:
                     currentFXAudioEffectParamStrs[0] = value;
+                    break;
+
+                case OptionKey::FXRParam1:
+                    currentFXAudioEffectParamStrs[1] = value;
+                    break;
+
+                default:
+                    optionLines.push_back({ chartLines.size(), lineNumber, optionKey, std::move(key), std::move(value) });
+                    break;
                 }
-                else if (key == "fx-r_param1")
+            }
+            else if (tokenizedLine.kind == LineKind::BarLine)
+            {
+                const std::size_t resolution = chartLines.size();
+                const Measure measureLength = UNIT_MEASURE * currentNumerator / currentDenominator;
+                const Measure lineYDiff = (resolution > 0) ? measureLength / static_cast<Measure>(resolution) : 0;
+                if (resolution == 0)
                 {
-                    currentFXAudioEffectParamStrs[1] = value;
+                    // Options are placed at the start of the measure
+                    addDiagnostic(DiagnosticSeverity::Warning, lineNumber, "Measure has no chart lines");
                 }
-                else
+                else if (lineYDiff == 0)
                 {
-                    optionLines.emplace_back(chartLines.size(), std::make_pair(key, value));
+                    addDiagnostic(DiagnosticSeverity::Warning, lineNumber, "Measure has more chart lines than its resolution (" + std::to_string(resolution) + " lines)");
                 }
-            }
-            else if (isBarLine(line))
-            {
-                std::size_t resolution = chartLines.size();
-                Measure lineYDiff = UNIT_MEASURE * currentNumerator / currentDenominator / resolution;
+
+                // Parse a numeric option value (reports invalid values)
+                const auto parseOptionValue = [this](const OptionLine & optionLine, const std::string & value, double & dValue)
+                {
+                    if (!parseDouble(value.c_str(), dValue))
+                    {
+                        addDiagnostic(DiagnosticSeverity::Warning, optionLine.lineNumber, "Invalid value \"" + optionLine.key + "=" + optionLine.value + "\"");
+                        return false;
+                    }
+                    return true;
+                };
 
                 // Add options that require their position
-                for (const auto & [ lineIdx, option ] : optionLines)
+                for (const OptionLine & optionLine : optionLines)
                 {
-                    const auto & [ key, value ] = option;
-                    Measure y = currentMeasure + lineYDiff * lineIdx;
-                    if (key == "t")
+                    const std::string & key = optionLine.key;
+                    const std::string & value = optionLine.value;
+                    Measure y = currentMeasure + lineYDiff * optionLine.lineIdx;
+                    switch (optionLine.optionKey)
                     {
+                    case OptionKey::Tempo:
                         insertTempoChange(tempoChanges, y, value);
-                    }
-                    else if (key == "zoom_top")
+                        break;
+
+                    case OptionKey::ZoomTop:
                     {
-                        double dValue = std::stod(value.substr(0, zoomMaxChar));
+                        double dValue;
+                        if (!parseOptionValue(optionLine, value.substr(0, zoomMaxChar), dValue))
+                        {
+                            break;
+                        }
                         if (std::abs(dValue) <= zoomAbsMax || (!isKshVersionNewerThanOrEqualTo(167) && m_zoomTop.count(y) > 0))
                         {
                             m_zoomTop.insert(y, dValue);
                         }
+                        break;
                     }
-                    else if (key == "zoom_bottom")
+
+                    case OptionKey::ZoomBottom:
                     {
-                        double dValue = std::stod(value.substr(0, zoomMaxChar));
+                        double dValue;
+                        if (!parseOptionValue(optionLine, value.substr(0, zoomMaxChar), dValue))
+                        {
+                            break;
+                        }
                         if (std::abs(dValue) <= zoomAbsMax || (!isKshVersionNewerThanOrEqualTo(167) && m_zoomBottom.count(y) > 0))
                         {
                             m_zoomBottom.insert(y, dValue);
                         }
+                        break;
                     }
-                    else if (key == "zoom_side")
+
+                    case OptionKey::ZoomSide:
                     {
-                        double dValue = std::stod(value.substr(0, zoomMaxChar));
+                        double dValue;
+                        if (!parseOptionValue(optionLine, value.substr(0, zoomMaxChar), dValue))
+                        {
+                            break;
+                        }
                         if (std::abs(dValue) <= zoomAbsMax || (!isKshVersionNewerThanOrEqualTo(167) && m_zoomSide.count(y) > 0))
                         {
                             m_zoomSide.insert(y, dValue);
                         }
+                        break;
                     }
-                    else if (key == "center_split")
+
+                    case OptionKey::CenterSplit:
                     {
-                        double dValue = std::stod(value);
+                        double dValue;
+                        if (!parseOptionValue(optionLine, value, dValue))
+                        {
+                            break;
+                        }
                         if (std::abs(dValue) <= CENTER_SPLIT_ABS_MAX)
                         {
                             m_centerSplit.insert(y, dValue);
                         }
+                        break;
                     }
-                    else if (key == "tilt")
-                    {
+
+                    case OptionKey::Tilt:
                         if (isManualTiltValue(value))
                         {
-                            double dValue = std::stod(value);
+                            double dValue;
+                            if (!parseOptionValue(optionLine, value, dValue))
+                            {
+                                break;
+                            }
                             if (std::abs(dValue) <= MANUAL_TILT_ABS_MAX)
                             {
-                                m_manualTilt.insert(y, std::stod(value));
-                                m_positionalOptions[key][y] = "manual";
+                                m_manualTilt.insert(y, dValue);
+                                positionalOptionValues(key)[y] = "manual";
                             }
                         }
                         else
                         {
-                            if (!m_positionalOptions[key].empty() && (*m_positionalOptions[key].rbegin()).second == "manual")
+                            if (!positionalOptionValues(key).empty() && (*positionalOptionValues(key).rbegin()).second == "manual")
                             {
                                 // Insert previous value to keep last value until non-manual tilt type is set
                                 m_manualTilt.insert(y, m_manualTilt.valueAt(y));
                             }
-                            m_positionalOptions[key][y] = value;
+                            positionalOptionValues(key)[y] = value;
                         }
-                    }
-                    else
-                    {
-                        m_positionalOptions[key][y] = value;
+                        break;
+
+                    default:
+                        positionalOptionValues(key)[y] = value;
+                        break;
                     }
                 }
 
                 // Add notes
                 for (std::size_t i = 0; i < resolution; ++i)
                 {
-                    const std::string buf = chartLines.at(i);
-                    std::size_t currentBlock = 0;
-                    std::size_t laneCount = 0;
-
+                    const ChartLineBlocks blocks = splitChartLine(chartLines[i]);
                     const Measure y = currentMeasure + lineYDiff * i;
 
-                    for (std::size_t j = 0; j < buf.size(); ++j)
+                    // BT notes
+                    forEachLaneChar<Layout::BT_LANE_COUNT>(blocks.bt, [&](std::size_t laneIdx, char c)
                     {
-                        if (buf[j] == BLOCK_SEPARATOR)
+                        switch (c)
                         {
-                            ++currentBlock;
-                            laneCount = 0;
-                            continue;
+                        case '2': // Long BT note
+                            btNoteBuilders[laneIdx].prepareNote(y, halvesCombo(currentTempo));
+                            btNoteBuilders[laneIdx].extendPreparedNoteLength(lineYDiff);
+                            break;
+                        case '1': // Chip BT note
+                            m_btLanes[laneIdx].emplace(y, BTNote(0));
+                            break;
+                        default:  // Empty
+                            btNoteBuilders[laneIdx].addPreparedNote();
                         }
+                    });
 
-                        if (currentBlock == BLOCK_BT) // BT notes
+                    // FX notes
+                    forEachLaneChar<Layout::FX_LANE_COUNT>(blocks.fx, [&](std::size_t laneIdx, char c)
+                    {
+                        switch (c)
                         {
-                            assert(laneCount < btNoteBuilders.size());
-                            switch (buf[j])
-                            {
-                            case '2': // Long BT note
-                                btNoteBuilders[laneCount].prepareNote(y, halvesCombo(currentTempo));
-                                btNoteBuilders[laneCount].extendPreparedNoteLength(lineYDiff);
-                                break;
-                            case '1': // Chip BT note
-                                m_btLanes[laneCount].emplace(y, BTNote(0));
-                                break;
-                            default:  // Empty
-                                btNoteBuilders[laneCount].addPreparedNote();
-                            }
+                        case '2': // Chip FX note
+                            m_fxLanes[laneIdx].emplace(y, FXNote(0));
+                            break;
+                        case '0': // Empty
+                            fxNoteBuilders[laneIdx].addPreparedNote();
+                            break;
+                        default:  // Long FX note
+                            const std::string audioEffectStr = (c == '1') ? currentFXAudioEffectStrs[laneIdx] : kshLegacyFXCharToAudioEffect(c);
+                            fxNoteBuilders[laneIdx].prepareNote(y, halvesCombo(currentTempo), audioEffectStr, currentFXAudioEffectParamStrs[laneIdx], m_isEditor);
+                            fxNoteBuilders[laneIdx].extendPreparedNoteLength(lineYDiff);
                         }
-                        else if (currentBlock == BLOCK_FX) // FX notes
+                    });
+
+                    // Laser notes
+                    forEachLaneChar<Layout::LASER_LANE_COUNT>(blocks.laser, [&](std::size_t laneIdx, char c)
+                    {
+                        switch (c)
                         {
-                            assert(laneCount < fxNoteBuilders.size());
-                            switch (buf[j])
+                        case '-': // Empty
+                            laserNoteBuilders[laneIdx].resetPreparedNote();
+                            break;
+                        case ':': // Connection
+                            laserNoteBuilders[laneIdx].extendPreparedNoteLength(lineYDiff);
+                            break;
+                        default:
+                            const int laserX = LaserNote::charToLaserX(c);
+                            if (laserX >= 0)
                             {
-                            case '2': // Chip FX note
-                                m_fxLanes[laneCount].emplace(y, FXNote(0));
-                                break;
-                            case '0': // Empty
-                                fxNoteBuilders[laneCount].addPreparedNote();
-                                break;
-                            default:  // Long FX note
-                                const std::string audioEffectStr = (buf[j] == '1') ? currentFXAudioEffectStrs[laneCount] : kshLegacyFXCharToAudioEffect(buf[j]);
-                                fxNoteBuilders[laneCount].prepareNote(y, halvesCombo(currentTempo), audioEffectStr, currentFXAudioEffectParamStrs[laneCount], isEditor);
-                                fxNoteBuilders[laneCount].extendPreparedNoteLength(lineYDiff);
+                                laserNoteBuilders[laneIdx].addPreparedNote(laserX);
+                                laserNoteBuilders[laneIdx].prepareNote(y, halvesCombo(currentTempo), laserX);
+                                laserNoteBuilders[laneIdx].extendPreparedNoteLength(lineYDiff);
                             }
                         }
-                        else if (currentBlock == BLOCK_LASER && laneCount < 2) // Laser notes
-                        {
-                            assert(laneCount < laserNoteBuilders.size());
-                            switch (buf[j])
-                            {
-                            case '-': // Empty
-                                laserNoteBuilders[laneCount].resetPreparedNote();
-                                break;
-                            case ':': // Connection
-                                laserNoteBuilders[laneCount].extendPreparedNoteLength(lineYDiff);
-                                break;
-                            default:
-                                const int laserX = LaserNote::charToLaserX(buf[j]);
-                                if (laserX >= 0)
-                                {
-                                    laserNoteBuilders[laneCount].addPreparedNote(laserX);
-                                    laserNoteBuilders[laneCount].prepareNote(y, halvesCombo(currentTempo), laserX);
-                                    laserNoteBuilders[laneCount].extendPreparedNoteLength(lineYDiff);
-                                }
-                            }
-                        }
-                        else if (currentBlock == BLOCK_LASER && laneCount == 2) // Lane spin
+                    });
+
+                    // Lane spin (after the laser notes in the laser block)
+                    if (blocks.laser.size() > Layout::LASER_LANE_COUNT)
+                    {
+                        // Create a lane spin from string
+                        const LaneSpin laneSpin(std::string(blocks.laser.substr(Layout::LASER_LANE_COUNT)));
+                        if (laneSpin.isValid())
                         {
-                            // Create a lane spin from string
-                            const LaneSpin laneSpin(buf.substr(j));
-                            if (laneSpin.isValid())
+                            // Assign to the laser note builder if valid
+                            for (auto && builder : laserNoteBuilders)
                             {
-                                // Assign to the laser note builder if valid
-                                for (std::size_t k = 0; k < laserNoteBuilders.size(); ++k)
-                                {
-                                    laserNoteBuilders[k].prepareLaneSpin(laneSpin);
-                                }
+                                builder.prepareLaneSpin(laneSpin);
                             }
                         }
-                        ++laneCount;
                     }
                 }
                 chartLines.clear();
@@ -437,18 +664,105 @@ namespace ksh
                 {
                     str.clear();
                 }
-                currentMeasure += UNIT_MEASURE * currentNumerator / currentDenominator;
+                currentMeasure += measureLength;
                 ++measureCount;
             }
         }
 
         m_ifs->close();
 
-        m_beatMap = std::make_unique<BeatMap>(tempoChanges, timeSigChanges);
+        // The beat map needs a tempo at the beginning
+        if (tempoChanges.count(0) == 0)
+        {
+            addDiagnostic(DiagnosticSeverity::Error, 0, "No tempo at the beginning of the chart");
+            tempoChanges.emplace(0, 120.0);
+        }
+
+        m_beatMap = std::make_shared<const BeatMap>(tempoChanges, timeSigChanges, m_resource);
+        m_beatGrid = BeatGrid(*m_beatMap, measureCount);
+
+        m_optionTracks = PositionalOptionTracks(m_positionalOptions, *m_beatMap);
+
+        buildLaserDerived();
+
+        const auto tiltItr = m_positionalOptions.find("tilt");
+        m_cameraTimeline = CameraTimeline(
+            { &m_zoomTop, &m_zoomBottom, &m_zoomSide, &m_centerSplit, &m_manualTilt },
+            (tiltItr != m_positionalOptions.end()) ? tiltItr->second : std::pmr::map<Measure, std::pmr::string>(),
+            *m_beatMap);
+
+        // Hi-speed is relative to the "to" tempo (the first tempo if missing)
+        double referenceTempo;
+        if (!metaData.count("to") || !parseTempo(std::string(metaData.at("to")), referenceTempo))
+        {
+            referenceTempo = m_beatMap->tempo(0);
+        }
+        m_scrollTimeline = ScrollTimeline(*m_beatMap, m_optionTracks.track(OptionKey::Stop), referenceTempo);
+
+        for (std::size_t laneIdx = 0; laneIdx < Layout::FX_LANE_COUNT; ++laneIdx)
+        {
+            buildFXDerived(laneIdx);
+        }
+        if (m_audioEffects.overflowed())
+        {
+            addDiagnostic(DiagnosticSeverity::Warning, 0, "Too many distinct audio effects (the rest of the FX notes have no audio effect)");
+        }
+    }
+
+    template <class Layout>
+    void BasicPlayableChart<Layout>::buildLaserDerived() const
+    {
+        for (std::size_t laneIdx = 0; laneIdx < Layout::LASER_LANE_COUNT; ++laneIdx)
+        {
+            // "laserrange_l=" and "laserrange_r=" (no range option for the other lanes)
+            const OptionKey rangeKey = (laneIdx == 0) ? OptionKey::LaserRangeL : OptionKey::LaserRangeR;
+            m_laserPolylines[laneIdx] = (laneIdx < 2)
+                ? LaserPolyline(m_laserLanes[laneIdx], *m_beatMap, m_optionTracks.track(rangeKey))
+                : LaserPolyline(m_laserLanes[laneIdx], *m_beatMap);
+        }
+
+        // Lane spins of slams (slams in both lanes on the same line share one lane spin)
+        std::map<Measure, LaneSpin> laneSpins;
+        for (const auto & lane : m_laserLanes)
+        {
+            for (const auto & [ y, note ] : lane)
+            {
+                if (note.laneSpin.isValid())
+                {
+                    laneSpins.emplace(y, note.laneSpin);
+                }
+            }
+        }
+        m_laneSpinTrack = LaneSpinTrack(laneSpins, *m_beatMap);
+    }
+
+    template <class Layout>
+    void BasicPlayableChart<Layout>::buildFXDerived(std::size_t laneIdx) const
+    {
+        m_audioEffectTimelines[laneIdx] = AudioEffectTimeline(m_fxLanes[laneIdx], m_audioEffects, *m_beatMap);
     }
 
-    std::size_t PlayableChart::comboCount() const
+    template <class Layout>
+    bool BasicPlayableChart<Layout>::shareBeatMap(const std::shared_ptr<const BeatMap> & beatMap)
     {
+        loadBody();
+
+        // (a beat map from another resource could outlive its memory, e.g. an arena of another chart)
+        if (beatMap == nullptr || beatMap->memoryResource() != m_resource || !beatMap->isEquivalentTo(*m_beatMap))
+        {
+            return false;
+        }
+
+        // Derived structures only hold values baked from the beat map, so they are still valid
+        m_beatMap = beatMap;
+        return true;
+    }
+
+    template <class Layout>
+    std::size_t BasicPlayableChart<Layout>::comboCount() const
+    {
+        loadBody();
+
         std::size_t sum = 0;
         for (auto && lane : m_btLanes)
         {
@@ -474,4 +788,101 @@ namespace ksh
         return sum;
     }
 
+    template <class Layout>
+    ChartMemoryUsage BasicPlayableChart<Layout>::memoryUsage() const
+    {
+        ChartMemoryUsage usage;
+        usage.bodyLoaded = isBodyLoaded();
+        usage.objectBytes = sizeof(*this)
+            + heapBlockBytes(sizeof(std::ifstream))
+            + heapBlockBytes(sizeof(BodyLoadState))
+            + stringMemoryUsage(m_filename).allocatedBytes
+            + stringMemoryUsage(m_fileDirectoryPath).allocatedBytes;
+
+        usage.metaData = hashMemoryUsage(metaData);
+        for (const auto & [ key, value ] : metaData)
+        {
+            usage.metaData += stringMemoryUsage(key);
+            usage.metaData += stringMemoryUsage(value);
+        }
+
+        if (!usage.bodyLoaded)
+        {
+            return usage;
+        }
+
+        usage.beatMap = m_beatMap->memoryUsage();
+        usage.beatMap.allocatedBytes += heapBlockBytes(sizeof(BeatMap));
+        usage.beatMap.usedBytes += sizeof(BeatMap);
+
+        for (const auto & lane : m_btLanes)
+        {
+            usage.btLanes += treeMemoryUsage(lane);
+            for (const auto & [ y, note ] : lane)
+            {
+                usage.noteJudgments += treeMemoryUsage(note.judgments());
+            }
+        }
+        for (const auto & lane : m_fxLanes)
+        {
+            usage.fxLanes += treeMemoryUsage(lane);
+            for (const auto & [ y, note ] : lane)
+            {
+                usage.noteJudgments += treeMemoryUsage(note.judgments());
+                usage.fxAudioEffectStrs += stringMemoryUsage(note.audioEffectStr);
+                usage.fxAudioEffectStrs += stringMemoryUsage(note.audioEffectParamStr);
+            }
+        }
+        for (const auto & lane : m_laserLanes)
+        {
+            usage.laserLanes += treeMemoryUsage(lane);
+            for (const auto & [ y, note ] : lane)
+            {
+                usage.noteJudgments += treeMemoryUsage(note.judgments());
+            }
+        }
+
+        for (const LineGraph * graph : { &m_zoomTop, &m_zoomBottom, &m_zoomSide, &m_centerSplit, &m_manualTilt })
+        {
+            usage.lineGraphs += graph->memoryUsage();
+        }
+
+        usage.positionalOptions = hashMemoryUsage(m_positionalOptions);
+        for (const auto & [ key, values ] : m_positionalOptions)
+        {
+            usage.positionalOptions += stringMemoryUsage(key);
+            usage.positionalOptions += treeMemoryUsage(values);
+            for (const auto & [ y, value ] : values)
+            {
+                usage.positionalOptions += stringMemoryUsage(value);
+            }
+        }
+
+        for (const auto & polyline : m_laserPolylines)
+        {
+            usage.derived += polyline.memoryUsage();
+        }
+        usage.derived += m_laneSpinTrack.memoryUsage();
+        usage.derived += m_beatGrid.memoryUsage();
+        usage.derived += m_cameraTimeline.memoryUsage();
+        usage.derived += m_optionTracks.memoryUsage();
+        usage.derived += m_scrollTimeline.memoryUsage();
+        usage.derived += m_audioEffects.memoryUsage();
+        for (const auto & timeline : m_audioEffectTimelines)
+        {
+            usage.derived += timeline.memoryUsage();
+        }
+
+        usage.diagnostics = vectorMemoryUsage(m_diagnostics);
+        for (const auto & diagnostic : m_diagnostics)
+        {
+            usage.diagnostics += stringMemoryUsage(diagnostic.message);
+        }
+
+        return usage;
+    }
+
+    template class BasicPlayableChart<DefaultLaneLayout>;
+    template class BasicPlayableChart<SixBTLaneLayout>;
+
 }
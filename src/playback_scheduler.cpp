@@ -0,0 +1,213 @@
+#include "ksh/playback_scheduler.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace ksh
+{
+
+    namespace
+    {
+        // Default value of "chokkakuvol=" (0-100 in .ksh)
+        constexpr double DEFAULT_SLAM_VOLUME = 0.5;
+
+        // Default values of "filtertype=" and "pfiltergain=" (0-100 in .ksh)
+        constexpr FilterType DEFAULT_FILTER_TYPE = FilterType::Peak;
+        constexpr double DEFAULT_FILTER_GAIN = 0.5;
+
+        PlaybackEvent makeEvent(Ms ms, PlaybackEventType type, uint8_t lane = 0, uint16_t param = 0, double value = 0.0)
+        {
+            return PlaybackEvent{ ms, value, 0, type, lane, param };
+        }
+    }
+
+    template <class Layout>
+    PlaybackScheduler::PlaybackScheduler(const BasicPlayableChart<Layout> & chart, Ms lookAheadMs)
+        : m_lookAheadMs(lookAheadMs)
+    {
+        const BeatMap & beatMap = chart.beatMap();
+        const PositionalOptionTracks & optionTracks = chart.optionTracks();
+
+        for (const auto & [ y, tempo ] : beatMap.tempoChanges())
+        {
+            m_events.push_back(makeEvent(beatMap.measureToMs(y), PlaybackEventType::TempoChange, 0, 0, tempo));
+        }
+
+        for (std::size_t laneIdx = 0; laneIdx < Layout::FX_LANE_COUNT; ++laneIdx)
+        {
+            for (const auto & interval : chart.audioEffectTimeline(laneIdx).intervals())
+            {
+                const uint8_t lane = static_cast<uint8_t>(laneIdx);
+                m_events.push_back(makeEvent(interval.startMs, PlaybackEventType::AudioEffectStart, lane, interval.effectIdx));
+                m_events.push_back(makeEvent(interval.endMs, PlaybackEventType::AudioEffectEnd, lane));
+            }
+        }
+
+        for (const auto & point : optionTracks.track(OptionKey::FilterType))
+        {
+            m_events.push_back(makeEvent(point.ms, PlaybackEventType::FilterTypeChange, 0, static_cast<uint16_t>(point.enumValue<FilterType>())));
+        }
+
+        for (const auto & point : optionTracks.track(OptionKey::PFilterGain))
+        {
+            m_events.push_back(makeEvent(point.ms, PlaybackEventType::FilterGainChange, 0, 0, point.value / 100));
+        }
+
+        for (std::size_t laneIdx = 0; laneIdx < Layout::LASER_LANE_COUNT; ++laneIdx)
+        {
+            for (const auto & [ y, note ] : chart.laserLanes()[laneIdx])
+            {
+                if (!note.isSlam() || note.startX == note.endX)
+                {
+                    continue;
+                }
+
+                const PositionalOptionTracks::Point * volumePoint = optionTracks.pointAt(OptionKey::ChokkakuVol, y);
+                const PositionalOptionTracks::Point * soundPoint = optionTracks.pointAt(OptionKey::ChokkakuSE, y);
+                m_events.push_back(makeEvent(
+                    beatMap.measureToMs(y),
+                    PlaybackEventType::SlamSound,
+                    static_cast<uint8_t>(laneIdx),
+                    static_cast<uint16_t>(soundPoint ? soundPoint->enumValue<SlamSound>() : SlamSound::Down),
+                    volumePoint ? volumePoint->value / 100 : DEFAULT_SLAM_VOLUME));
+            }
+        }
+
+        std::stable_sort(m_events.begin(), m_events.end(), [](const PlaybackEvent & lhs, const PlaybackEvent & rhs)
+        {
+            return (lhs.ms != rhs.ms) ? (lhs.ms < rhs.ms) : (lhs.type < rhs.type);
+        });
+
+        // State tracks: tempo, filter type, filter gain, then the FX lanes
+        constexpr std::size_t FX_STATE_TRACK_OFFSET = 3;
+        m_stateTracks.resize(FX_STATE_TRACK_OFFSET + Layout::FX_LANE_COUNT);
+        m_stateTracks[0].initialEvent = makeEvent(0.0, PlaybackEventType::TempoChange, 0, 0, beatMap.tempo(0));
+        m_stateTracks[1].initialEvent = makeEvent(0.0, PlaybackEventType::FilterTypeChange, 0, static_cast<uint16_t>(DEFAULT_FILTER_TYPE));
+        m_stateTracks[2].initialEvent = makeEvent(0.0, PlaybackEventType::FilterGainChange, 0, 0, DEFAULT_FILTER_GAIN);
+        for (std::size_t laneIdx = 0; laneIdx < Layout::FX_LANE_COUNT; ++laneIdx)
+        {
+            m_stateTracks[FX_STATE_TRACK_OFFSET + laneIdx].initialEvent = makeEvent(0.0, PlaybackEventType::AudioEffectEnd, static_cast<uint8_t>(laneIdx));
+        }
+        for (std::size_t i = 0; i < m_events.size(); ++i)
+        {
+            const PlaybackEvent & event = m_events[i];
+            switch (event.type)
+            {
+            case PlaybackEventType::TempoChange:
+                m_stateTracks[0].eventIdxs.push_back(i);
+                break;
+            case PlaybackEventType::FilterTypeChange:
+                m_stateTracks[1].eventIdxs.push_back(i);
+                break;
+            case PlaybackEventType::FilterGainChange:
+                m_stateTracks[2].eventIdxs.push_back(i);
+                break;
+            case PlaybackEventType::AudioEffectStart:
+            case PlaybackEventType::AudioEffectEnd:
+                m_stateTracks[FX_STATE_TRACK_OFFSET + event.lane].eventIdxs.push_back(i);
+                break;
+            default:
+                break;
+            }
+        }
+
+        // (allocated here so that seek() does not allocate)
+        m_stateEvents.resize(m_stateTracks.size());
+        m_nextStateEventIdx = m_stateEvents.size();
+    }
+
+    bool PlaybackScheduler::pushStateEvents(std::size_t & count)
+    {
+        while (m_nextStateEventIdx < m_stateEvents.size())
+        {
+            if (!m_queue.tryPush(m_stateEvents[m_nextStateEventIdx]))
+            {
+                return false;
+            }
+            ++m_nextStateEventIdx;
+            ++count;
+        }
+        return true;
+    }
+
+    std::size_t PlaybackScheduler::pump(Ms currentMs)
+    {
+        const uint32_t generation = m_generation.load(std::memory_order_relaxed);
+        const Ms endMs = currentMs + m_lookAheadMs;
+        std::size_t count = 0;
+        if (!pushStateEvents(count))
+        {
+            return count;
+        }
+        while (m_nextEventIdx < m_events.size() && m_events[m_nextEventIdx].ms < endMs)
+        {
+            PlaybackEvent event = m_events[m_nextEventIdx];
+            event.generation = generation;
+            if (!m_queue.tryPush(event))
+            {
+                break;
+            }
+            ++m_nextEventIdx;
+            ++count;
+        }
+        return count;
+    }
+
+    void PlaybackScheduler::seek(Ms ms)
+    {
+        const uint32_t generation = m_generation.fetch_add(1, std::memory_order_release) + 1;
+        m_nextEventIdx = static_cast<std::size_t>(std::distance(
+            m_events.begin(),
+            std::lower_bound(m_events.begin(), m_events.end(), ms, [](const PlaybackEvent & event, Ms value) { return event.ms < value; })));
+
+        // Last event of each state track before m_nextEventIdx
+        for (std::size_t i = 0; i < m_stateTracks.size(); ++i)
+        {
+            const StateTrack & track = m_stateTracks[i];
+            const auto itr = std::lower_bound(track.eventIdxs.begin(), track.eventIdxs.end(), m_nextEventIdx);
+            PlaybackEvent event = (itr == track.eventIdxs.begin()) ? track.initialEvent : m_events[*std::prev(itr)];
+            event.ms = ms;
+            event.generation = generation;
+            m_stateEvents[i] = event;
+        }
+        m_nextStateEventIdx = 0;
+
+        // Queued now if there is room (otherwise by the next pump())
+        std::size_t count = 0;
+        pushStateEvents(count);
+    }
+
+    bool PlaybackScheduler::popUntil(Ms endMs, PlaybackEvent & event)
+    {
+        uint32_t generation = m_generation.load(std::memory_order_acquire);
+        while (const PlaybackEvent * front = m_queue.front())
+        {
+            // (wrap-aware comparison of generations)
+            const int32_t generationDiff = static_cast<int32_t>(front->generation - generation);
+            if (generationDiff > 0)
+            {
+                // Queued after a seek() during this call (the event is current, so take the new generation)
+                generation = m_generation.load(std::memory_order_acquire);
+                continue;
+            }
+            if (generationDiff < 0)
+            {
+                // Queued before seek()
+                m_queue.pop();
+                continue;
+            }
+            if (front->ms >= endMs)
+            {
+                return false;
+            }
+            event = *front;
+            m_queue.pop();
+            return true;
+        }
+        return false;
+    }
+
+    template PlaybackScheduler::PlaybackScheduler(const BasicPlayableChart<DefaultLaneLayout> &, Ms);
+    template PlaybackScheduler::PlaybackScheduler(const BasicPlayableChart<SixBTLaneLayout> &, Ms);
+
+}
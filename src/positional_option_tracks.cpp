@@ -0,0 +1,182 @@
+#include "ksh/positional_option_tracks.hpp"
+
+#include <algorithm>
+
+#include "parse_number.hpp"
+
+namespace ksh
+{
+
+    namespace
+    {
+        bool parseEnum(OptionKey key, const std::pmr::string & str, int & value)
+        {
+            switch (key)
+            {
+            case OptionKey::LaserRangeL:
+            case OptionKey::LaserRangeR:
+                if (str == "1x")
+                {
+                    value = static_cast<int>(LaserRange::Normal);
+                    return true;
+                }
+                else if (str == "2x")
+                {
+                    value = static_cast<int>(LaserRange::Wide);
+                    return true;
+                }
+                return false;
+
+            case OptionKey::FilterType:
+                if (str == "peak")
+                {
+                    value = static_cast<int>(FilterType::Peak);
+                }
+                else if (str == "lpf1")
+                {
+                    value = static_cast<int>(FilterType::LowPass);
+                }
+                else if (str == "hpf1")
+                {
+                    value = static_cast<int>(FilterType::HighPass);
+                }
+                else if (str == "bitc" || str == "fx;bitc")
+                {
+                    value = static_cast<int>(FilterType::BitCrusher);
+                }
+                else
+                {
+                    value = static_cast<int>(FilterType::Custom);
+                }
+                return true;
+
+            case OptionKey::ChokkakuSE:
+                if (str == "down")
+                {
+                    value = static_cast<int>(SlamSound::Down);
+                }
+                else if (str == "up")
+                {
+                    value = static_cast<int>(SlamSound::Up);
+                }
+                else if (str == "swing")
+                {
+                    value = static_cast<int>(SlamSound::Swing);
+                }
+                else if (str == "mute")
+                {
+                    value = static_cast<int>(SlamSound::Mute);
+                }
+                else
+                {
+                    return false;
+                }
+                return true;
+
+            default:
+                return false;
+            }
+        }
+    }
+
+    const PositionalOptionTracks::Track PositionalOptionTracks::s_emptyTrack;
+
+    OptionValueType optionValueType(OptionKey key)
+    {
+        switch (key)
+        {
+        case OptionKey::PFilterGain:
+        case OptionKey::ChokkakuVol:
+            return OptionValueType::Numeric;
+
+        case OptionKey::LaserRangeL:
+        case OptionKey::LaserRangeR:
+        case OptionKey::FilterType:
+        case OptionKey::ChokkakuSE:
+            return OptionValueType::Enum;
+
+        case OptionKey::Stop:
+        case OptionKey::LaneToggle:
+            return OptionValueType::Duration;
+
+        default:
+            return OptionValueType::None;
+        }
+    }
+
+    PositionalOptionTracks::PositionalOptionTracks(const PositionalOptions & positionalOptions, const BeatMap & beatMap)
+    {
+        for (const auto & [ keyStr, values ] : positionalOptions)
+        {
+            const OptionKey key = toOptionKey(keyStr);
+            const OptionValueType type = optionValueType(key);
+            if (type == OptionValueType::None)
+            {
+                continue;
+            }
+
+            Track & track = m_tracks[static_cast<std::size_t>(key)];
+            track.reserve(values.size());
+            for (const auto & [ y, valueStr ] : values)
+            {
+                Point point{ y, beatMap.measureToMs(y), 0.0, 0.0 };
+                switch (type)
+                {
+                case OptionValueType::Numeric:
+                    if (!parseDouble(valueStr.c_str(), point.value))
+                    {
+                        continue;
+                    }
+                    break;
+
+                case OptionValueType::Enum:
+                {
+                    int enumValue;
+                    if (!parseEnum(key, valueStr, enumValue))
+                    {
+                        continue;
+                    }
+                    point.value = enumValue;
+                    break;
+                }
+
+                case OptionValueType::Duration:
+                {
+                    // Length in .ksh is 192 per measure
+                    double kshLength;
+                    if (!parseDouble(valueStr.c_str(), kshLength) || kshLength < 0.0)
+                    {
+                        continue;
+                    }
+                    const Measure length = static_cast<Measure>(kshLength * UNIT_MEASURE / 192);
+                    point.value = static_cast<double>(length);
+                    point.durationMs = beatMap.measureToMs(y + length) - point.ms;
+                    break;
+                }
+
+                default:
+                    continue;
+                }
+                track.push_back(point);
+            }
+        }
+    }
+
+    const PositionalOptionTracks::Point * PositionalOptionTracks::pointAt(OptionKey key, Measure y) const
+    {
+        const Track & t = track(key);
+        const auto itr = std::upper_bound(t.begin(), t.end(), y, [](Measure value, const Point & point) { return value < point.y; });
+        return (itr == t.begin()) ? nullptr : &*std::prev(itr);
+    }
+
+    MemoryUsage PositionalOptionTracks::memoryUsage() const
+    {
+        MemoryUsage usage;
+        for (const Track & t : m_tracks)
+        {
+            usage += vectorMemoryUsage(t);
+        }
+        return usage;
+    }
+
+}
@@ -0,0 +1,186 @@
+#include "ksh/scroll_timeline.hpp"
+
+#include <map>
+#include <set>
+#include <algorithm>
+#include <iterator>
+
+namespace ksh
+{
+
+    ScrollTimeline::ScrollTimeline(const BeatMap & beatMap, const PositionalOptionTracks::Track & stops, double referenceTempo)
+        : m_referenceTempo((referenceTempo > 0.0) ? referenceTempo : 120.0)
+        , m_distancePerMeasure(4.0 * 60 * 1000 / UNIT_MEASURE / m_referenceTempo)
+    {
+        // Merge overlapping stops into [start, end) intervals
+        std::map<Measure, Measure> stopIntervals;
+        for (const auto & stop : stops)
+        {
+            const Measure start = stop.y;
+            const Measure end = stop.y + static_cast<Measure>(stop.value);
+            if (end <= start)
+            {
+                continue;
+            }
+            if (!stopIntervals.empty())
+            {
+                auto & last = *stopIntervals.rbegin();
+                if (start <= last.second)
+                {
+                    last.second = std::max(last.second, end);
+                    continue;
+                }
+            }
+            stopIntervals.emplace(start, end);
+        }
+
+        // Breakpoints (the beat map starts at 0, so the first breakpoint is at 0)
+        std::set<Measure> breakpoints{ 0 };
+        for (const auto & [ y, tempo ] : beatMap.tempoChanges())
+        {
+            breakpoints.insert(y);
+        }
+        for (const auto & [ start, end ] : stopIntervals)
+        {
+            breakpoints.insert(start);
+            breakpoints.insert(end);
+        }
+
+        const std::size_t count = breakpoints.size();
+        m_breakpointYs.reserve(count);
+        m_breakpointMs.reserve(count);
+        m_distances.reserve(count);
+        m_slopes.reserve(count);
+
+        double distance = 0.0;
+        auto stopItr = stopIntervals.begin();
+        for (const Measure y : breakpoints)
+        {
+            // Distance at y from the previous breakpoint
+            if (!m_breakpointYs.empty())
+            {
+                distance = distanceAtMeasure(m_breakpointYs.size() - 1, y);
+            }
+
+            // Whether y is in a stop
+            while (stopItr != stopIntervals.end() && stopItr->second <= y)
+            {
+                ++stopItr;
+            }
+            const bool stopped = (stopItr != stopIntervals.end() && stopItr->first <= y);
+
+            m_breakpointYs.push_back(y);
+            m_breakpointMs.push_back(beatMap.measureToMs(y));
+            m_distances.push_back(distance);
+            m_slopes.push_back(stopped ? 0.0 : beatMap.tempo(y) / m_referenceTempo);
+        }
+    }
+
+    std::size_t ScrollTimeline::intervalIdxAtMeasure(Measure y) const
+    {
+        const auto itr = std::upper_bound(m_breakpointYs.begin(), m_breakpointYs.end(), y);
+        return (itr == m_breakpointYs.begin()) ? 0 : static_cast<std::size_t>(std::distance(m_breakpointYs.begin(), itr)) - 1;
+    }
+
+    std::size_t ScrollTimeline::intervalIdxAt(Ms ms) const
+    {
+        const auto itr = std::upper_bound(m_breakpointMs.begin(), m_breakpointMs.end(), ms);
+        return (itr == m_breakpointMs.begin()) ? 0 : static_cast<std::size_t>(std::distance(m_breakpointMs.begin(), itr)) - 1;
+    }
+
+    double ScrollTimeline::distanceAt(Ms ms) const
+    {
+        if (m_breakpointMs.empty())
+        {
+            return 0.0;
+        }
+        return distanceAt(intervalIdxAt(ms), ms);
+    }
+
+    double ScrollTimeline::distanceAtMeasure(Measure y) const
+    {
+        if (m_breakpointYs.empty())
+        {
+            return 0.0;
+        }
+        return distanceAtMeasure(intervalIdxAtMeasure(y), y);
+    }
+
+    void ScrollTimeline::distancesAt(const Ms * ms, double * dest, std::size_t count) const
+    {
+        if (m_breakpointMs.empty())
+        {
+            std::fill(dest, dest + count, 0.0);
+            return;
+        }
+
+        std::size_t idx = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (ms[i] < m_breakpointMs[idx])
+            {
+                // Not sorted
+                idx = intervalIdxAt(ms[i]);
+            }
+            else
+            {
+                while (idx + 1 < m_breakpointMs.size() && m_breakpointMs[idx + 1] <= ms[i])
+                {
+                    ++idx;
+                }
+            }
+            dest[i] = distanceAt(idx, ms[i]);
+        }
+    }
+
+    void ScrollTimeline::distancesAtMeasures(const Measure * ys, double * dest, std::size_t count) const
+    {
+        if (m_breakpointYs.empty())
+        {
+            std::fill(dest, dest + count, 0.0);
+            return;
+        }
+
+        std::size_t idx = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (ys[i] < m_breakpointYs[idx])
+            {
+                // Not sorted
+                idx = intervalIdxAtMeasure(ys[i]);
+            }
+            else
+            {
+                while (idx + 1 < m_breakpointYs.size() && m_breakpointYs[idx + 1] <= ys[i])
+                {
+                    ++idx;
+                }
+            }
+            dest[i] = distanceAtMeasure(idx, ys[i]);
+        }
+    }
+
+    double ScrollTimeline::Cursor::distanceAt(Ms ms)
+    {
+        const std::vector<Ms> & breakpointMs = m_timeline->m_breakpointMs;
+        if (breakpointMs.empty())
+        {
+            return 0.0;
+        }
+
+        if (ms < breakpointMs[m_idx])
+        {
+            // Time went backward
+            m_idx = m_timeline->intervalIdxAt(ms);
+        }
+        else
+        {
+            while (m_idx + 1 < breakpointMs.size() && breakpointMs[m_idx + 1] <= ms)
+            {
+                ++m_idx;
+            }
+        }
+        return m_timeline->distanceAt(m_idx, ms);
+    }
+
+}
@@ -0,0 +1,135 @@
+#include "ksh/song.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace ksh
+{
+
+    namespace
+    {
+        std::vector<std::string> chartFilenamesInDirectory(std::string_view directoryPath)
+        {
+            std::vector<std::string> chartFilenames;
+            std::error_code ec;
+            for (auto itr = std::filesystem::directory_iterator(directoryPath, ec); !ec && itr != std::filesystem::directory_iterator(); itr.increment(ec))
+            {
+                if (itr->path().extension() == ".ksh" && itr->is_regular_file(ec))
+                {
+                    chartFilenames.push_back(itr->path().string());
+                }
+            }
+            std::sort(chartFilenames.begin(), chartFilenames.end());
+            return chartFilenames;
+        }
+    }
+
+    template <class Layout>
+    BasicSong<Layout>::BasicSong(std::string_view directoryPath, std::size_t threadCount)
+        : BasicSong(chartFilenamesInDirectory(directoryPath), threadCount)
+    {
+    }
+
+    template <class Layout>
+    BasicSong<Layout>::BasicSong(const std::vector<std::string> & chartFilenames, std::size_t threadCount)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        threadCount = std::max<std::size_t>(std::min(threadCount, chartFilenames.size()), 1);
+
+        // Parse the difficulties in parallel (nullptr = failed)
+        std::vector<std::unique_ptr<ChartType>> charts(chartFilenames.size());
+        std::atomic<std::size_t> nextIdx(0);
+        const auto worker = [&]()
+        {
+            for (std::size_t i = nextIdx++; i < chartFilenames.size(); i = nextIdx++)
+            {
+                std::error_code ec;
+                if (!std::filesystem::is_regular_file(chartFilenames[i], ec))
+                {
+                    continue;
+                }
+
+                // Broken charts are reported in failedFilenames() (the parser reports problems as diagnostics instead of throwing)
+                auto chart = std::make_unique<ChartType>(chartFilenames[i], BodyLoadPolicy::Immediate);
+                if (!hasError(chart->diagnostics()))
+                {
+                    charts[i] = std::move(chart);
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < threadCount; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto && thread : threads)
+        {
+            thread.join();
+        }
+
+        // Share equivalent beat maps (difficulties of a song usually have the same tempo changes and time signatures;
+        // all charts are allocated from the default memory resource, so shareBeatMap() accepts beat maps of each other)
+        std::vector<std::shared_ptr<const BeatMap>> beatMaps;
+        for (std::size_t i = 0; i < charts.size(); ++i)
+        {
+            if (charts[i] == nullptr)
+            {
+                m_failedFilenames.push_back(chartFilenames[i]);
+                continue;
+            }
+
+            const bool shared = std::any_of(beatMaps.begin(), beatMaps.end(), [&chart = *charts[i]](const auto & beatMap) { return chart.shareBeatMap(beatMap); });
+            if (!shared)
+            {
+                beatMaps.push_back(charts[i]->sharedBeatMap());
+            }
+        }
+        m_beatMapCount = beatMaps.size();
+
+        charts.erase(std::remove(charts.begin(), charts.end(), nullptr), charts.end());
+        std::stable_sort(charts.begin(), charts.end(), [](const auto & a, const auto & b) { return a->difficultyIdx() < b->difficultyIdx(); });
+
+        // Meta data shared by all difficulties
+        if (!charts.empty())
+        {
+            for (const auto & [ key, value ] : charts.front()->metaData)
+            {
+                const bool common = std::all_of(std::next(charts.begin()), charts.end(), [&key = key, &value = value](const auto & chart)
+                {
+                    const auto itr = chart->metaData.find(key);
+                    return itr != chart->metaData.end() && itr->second == value;
+                });
+                if (common)
+                {
+                    m_metaData.emplace(key, value);
+                }
+            }
+        }
+
+        m_charts.reserve(charts.size());
+        for (auto && chart : charts)
+        {
+            m_charts.push_back(FrozenChartType::freeze(std::move(chart)));
+        }
+    }
+
+    template <class Layout>
+    const typename BasicSong<Layout>::ChartType * BasicSong<Layout>::chartOfDifficulty(int difficultyIdx) const
+    {
+        const auto itr = std::find_if(m_charts.begin(), m_charts.end(), [difficultyIdx](const FrozenChartType & chart) { return chart->difficultyIdx() == difficultyIdx; });
+        return (itr == m_charts.end()) ? nullptr : &itr->get();
+    }
+
+    template class BasicSong<DefaultLaneLayout>;
+    template class BasicSong<SixBTLaneLayout>;
+
+}
@@ -0,0 +1,134 @@
+// diffCharts() between charts whose headers and positional options differ
+// (build with -DKSH_SANITIZE=address to check the lifetime of the diff entries)
+//
+// Usage: chart_diff_test <before.ksh> <after.ksh>
+// (tests/data/basic.ksh and tests/data/basic_edited.ksh)
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "ksh/chart_diff.hpp"
+
+namespace
+{
+    std::size_t s_failureCount = 0;
+
+    void check(bool condition, const char * description)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", description);
+            ++s_failureCount;
+        }
+    }
+
+    template <typename T>
+    std::string str(const T * value)
+    {
+        return (value == nullptr) ? "(none)" : std::string(*value);
+    }
+
+    // Entry of a sorted metaData diff with the key (nullptr if missing)
+    const ksh::DiffEntry<std::string_view, std::pmr::string> * findMetaData(const ksh::ChartDiff & diff, std::string_view key)
+    {
+        for (const auto & entry : diff.metaData)
+        {
+            if (entry.key == key)
+            {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    const ksh::MeasureDiff<std::pmr::string> * findPositionalOption(const ksh::ChartDiff & diff, std::string_view key)
+    {
+        for (const auto & [ optionKey, entries ] : diff.positionalOptions)
+        {
+            if (optionKey == key)
+            {
+                return &entries;
+            }
+        }
+        return nullptr;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "Usage: %s <before.ksh> <after.ksh>\n", argv[0]);
+        return 2;
+    }
+
+    const ksh::PlayableChart before(argv[1]);
+    const ksh::PlayableChart after(argv[2]);
+
+    // Identical charts
+    check(ksh::diffCharts(before, before).empty(), "diff of a chart with itself is empty");
+
+    const ksh::ChartDiff diff = ksh::diffCharts(before, after);
+
+    // Header
+    check(diff.metaData.size() == 3, "three header entries differ");
+    if (const auto entry = findMetaData(diff, "title"))
+    {
+        check(entry->kind == ksh::DiffKind::Modified, "title is modified");
+        check(str(entry->after) == "Edited", "new title is read from the after chart");
+    }
+    else
+    {
+        check(false, "title is in the diff");
+    }
+    if (const auto entry = findMetaData(diff, "artist"))
+    {
+        check(entry->kind == ksh::DiffKind::Removed && str(entry->before) == "Someone" && entry->after == nullptr, "artist is removed");
+    }
+    else
+    {
+        check(false, "artist is in the diff");
+    }
+    if (const auto entry = findMetaData(diff, "genre"))
+    {
+        check(entry->kind == ksh::DiffKind::Added && entry->before == nullptr && str(entry->after) == "test", "genre is added");
+    }
+    else
+    {
+        check(false, "genre is in the diff");
+    }
+
+    // Positional options
+    check(diff.positionalOptions.size() == 3, "three positional options differ");
+    if (const auto entries = findPositionalOption(diff, "laserrange_l"); entries != nullptr && entries->size() == 1)
+    {
+        const auto & entry = entries->front();
+        check(entry.kind == ksh::DiffKind::Modified && str(entry.before) == "2x" && str(entry.after) == "1x", "laserrange_l is modified");
+    }
+    else
+    {
+        check(false, "laserrange_l has one entry");
+    }
+    if (const auto entries = findPositionalOption(diff, "stop"); entries != nullptr && entries->size() == 1)
+    {
+        check(entries->front().kind == ksh::DiffKind::Removed && str(entries->front().before) == "96", "stop is removed");
+    }
+    else
+    {
+        check(false, "stop has one entry");
+    }
+    if (const auto entries = findPositionalOption(diff, "chokkakuvol"); entries != nullptr && entries->size() == 1)
+    {
+        check(entries->front().kind == ksh::DiffKind::Added && str(entries->front().after) == "80", "chokkakuvol is added");
+    }
+    else
+    {
+        check(false, "chokkakuvol has one entry");
+    }
+
+    check(diff.size() == 6, "six entries in total");
+
+    std::printf("%zu failures\n", s_failureCount);
+    return (s_failureCount == 0) ? 0 : 1;
+}
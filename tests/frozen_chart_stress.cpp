@@ -0,0 +1,168 @@
+// Concurrent const access to a shared chart (build with -DKSH_SANITIZE=thread to check for data races)
+//
+// Usage: frozen_chart_stress <chart.ksh> [threads] [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include "ksh/playable_chart.hpp"
+#include "ksh/frozen_chart.hpp"
+
+namespace
+{
+    constexpr Ms SAMPLE_STEP_MS = 7.5;
+
+    // Values read from every kind of structure of a chart (compared between threads)
+    struct Reading
+    {
+        double sum = 0.0;
+        std::size_t count = 0;
+
+        void add(double value)
+        {
+            sum += value;
+            ++count;
+        }
+
+        bool operator==(const Reading & other) const
+        {
+            return sum == other.sum && count == other.count;
+        }
+    };
+
+    Reading readChart(const ksh::PlayableChart & chart)
+    {
+        Reading reading;
+
+        const BeatMap & beatMap = chart.beatMap();
+        const Measure endY = beatMap.measureCountToMeasure(16);
+        for (Measure y = 0; y < endY; y += UNIT_MEASURE / 16)
+        {
+            const Ms ms = beatMap.measureToMs(y);
+            reading.add(ms);
+            reading.add(static_cast<double>(beatMap.msToMeasure(ms)));
+            reading.add(static_cast<double>(beatMap.measureToUs(y)));
+            reading.add(beatMap.tempo(y));
+            reading.add(beatMap.timeSig(y).numerator);
+            reading.add(beatMap.isBarLine(y) ? 1.0 : 0.0);
+            reading.add(chart.scrollTimeline().distanceAtMeasure(y));
+        }
+
+        for (const auto & lane : chart.btLanes())
+        {
+            for (const auto & [ y, note ] : lane)
+            {
+                reading.add(static_cast<double>(y + note.length));
+            }
+        }
+        for (const auto & lane : chart.laserLanes())
+        {
+            for (const auto & [ y, note ] : lane)
+            {
+                reading.add(note.startX + note.endX);
+            }
+        }
+        reading.add(static_cast<double>(chart.comboCount()));
+
+        const Ms endMs = beatMap.measureToMs(endY);
+        auto cameraCursor = chart.cameraTimeline().cursor();
+        auto scrollCursor = chart.scrollTimeline().cursor();
+        for (Ms ms = 0.0; ms < endMs; ms += SAMPLE_STEP_MS)
+        {
+            const ksh::CameraState state = cameraCursor.stateAt(ms);
+            reading.add(state.zoomTop + state.zoomBottom + state.centerSplit + state.manualTilt);
+            reading.add(scrollCursor.distanceAt(ms));
+            reading.add(chart.laneSpinTrack().transformAt(ms).rotation);
+            for (const auto & polyline : chart.laserPolylines())
+            {
+                const double x = polyline.xAt(ms);
+                reading.add(std::isnan(x) ? -1.0 : x); // (NaN if there is no laser)
+            }
+            for (const auto & timeline : chart.audioEffectTimelines())
+            {
+                reading.add(static_cast<double>(timeline.effectIdxAt(ms)));
+            }
+        }
+
+        for (const auto & line : chart.beatGrid().lines())
+        {
+            reading.add(line.ms);
+        }
+
+        return reading;
+    }
+
+    // Run readChart() on threadCount threads at once and count the results that differ from expected
+    std::size_t runThreads(const ksh::PlayableChart & chart, const Reading & expected, std::size_t threadCount, std::size_t iterationCount)
+    {
+        std::atomic<std::size_t> mismatchCount(0);
+        std::atomic<bool> start(false);
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < threadCount; ++i)
+        {
+            threads.emplace_back([&]()
+            {
+                while (!start.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+                for (std::size_t j = 0; j < iterationCount; ++j)
+                {
+                    if (!(readChart(chart) == expected))
+                    {
+                        ++mismatchCount;
+                    }
+                }
+            });
+        }
+        start.store(true, std::memory_order_release);
+        for (auto && thread : threads)
+        {
+            thread.join();
+        }
+        return mismatchCount.load();
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <chart.ksh> [threads] [iterations]\n", argv[0]);
+        return 2;
+    }
+    const std::size_t threadCount = (argc >= 3) ? std::strtoul(argv[2], nullptr, 10) : 8;
+    const std::size_t iterationCount = (argc >= 4) ? std::strtoul(argv[3], nullptr, 10) : 50;
+
+    const ksh::PlayableChart reference(argv[1]);
+    const Reading expected = readChart(reference);
+    if (expected.count == 0)
+    {
+        std::fprintf(stderr, "Failed to read %s\n", argv[1]);
+        return 1;
+    }
+
+    std::size_t failureCount = 0;
+
+    // Snapshot shared between threads
+    {
+        const ksh::FrozenChart frozen = ksh::FrozenChart::load(argv[1]);
+        const std::size_t mismatchCount = runThreads(frozen.get(), expected, threadCount, iterationCount);
+        std::printf("FrozenChart: %zu mismatches\n", mismatchCount);
+        failureCount += mismatchCount;
+    }
+
+    // On-demand body loaded by whichever thread comes first
+    {
+        const ksh::PlayableChart chart(argv[1], ksh::BodyLoadPolicy::OnDemand);
+        const std::size_t mismatchCount = runThreads(chart, expected, threadCount, iterationCount);
+        std::printf("OnDemand: %zu mismatches\n", mismatchCount);
+        failureCount += mismatchCount;
+    }
+
+    return (failureCount == 0) ? 0 : 1;
+}
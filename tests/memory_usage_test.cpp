@@ -0,0 +1,118 @@
+// PlayableChart::memoryUsage() against the bytes actually allocated from the chart's memory resource
+//
+// Usage: memory_usage_test <chart.ksh>
+// (tests/data/basic.ksh)
+
+#include <cstdio>
+#include <cstddef>
+#include <memory_resource>
+
+#include "ksh/playable_chart.hpp"
+
+namespace
+{
+    // Upper bound of heapBlockBytes(n) - n (chunk header and alignment, or the minimum chunk size)
+    constexpr std::size_t MAX_MALLOC_OVERHEAD = sizeof(std::size_t) * 4;
+
+    std::size_t s_failureCount = 0;
+
+    void check(bool condition, const char * description)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", description);
+            ++s_failureCount;
+        }
+    }
+
+    // Memory resource that counts the live bytes requested from it
+    class CountingResource : public std::pmr::memory_resource
+    {
+    private:
+        std::pmr::memory_resource * const m_upstream;
+        std::size_t m_liveBytes = 0;
+        std::size_t m_liveBlockCount = 0;
+
+        void * do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            void * p = m_upstream->allocate(bytes, alignment);
+            m_liveBytes += bytes;
+            ++m_liveBlockCount;
+            return p;
+        }
+
+        void do_deallocate(void * p, std::size_t bytes, std::size_t alignment) override
+        {
+            m_upstream->deallocate(p, bytes, alignment);
+            m_liveBytes -= bytes;
+            --m_liveBlockCount;
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override
+        {
+            return this == &other;
+        }
+
+    public:
+        explicit CountingResource(std::pmr::memory_resource * upstream = std::pmr::new_delete_resource()) : m_upstream(upstream) {}
+
+        std::size_t liveBytes() const
+        {
+            return m_liveBytes;
+        }
+
+        std::size_t liveBlockCount() const
+        {
+            return m_liveBlockCount;
+        }
+    };
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <chart.ksh>\n", argv[0]);
+        return 2;
+    }
+
+    CountingResource resource;
+    {
+        const ksh::PlayableChart chart(argv[1], ksh::BodyLoadPolicy::Immediate, &resource);
+        const ksh::ChartMemoryUsage usage = chart.memoryUsage();
+        check(usage.bodyLoaded, "the body is loaded");
+
+        // Components allocated from the chart's resource
+        // (the BeatMap object itself, the audio effect strings of FX notes, the diagnostics and the derived structures use the global heap)
+        ksh::MemoryUsage resourceUsage;
+        for (const ksh::MemoryUsage * component : { &usage.metaData, &usage.beatMap, &usage.btLanes, &usage.fxLanes, &usage.laserLanes, &usage.noteJudgments, &usage.lineGraphs, &usage.positionalOptions })
+        {
+            resourceUsage += *component;
+        }
+        resourceUsage.allocatedBytes -= ksh::heapBlockBytes(sizeof(BeatMap));
+        resourceUsage.usedBytes -= sizeof(BeatMap);
+
+        // usedBytes counts the elements only, and allocatedBytes adds the node overhead and malloc rounding to each block
+        std::printf("resource: %zu bytes in %zu blocks, usedBytes: %zu, allocatedBytes: %zu\n",
+            resource.liveBytes(), resource.liveBlockCount(), resourceUsage.usedBytes, resourceUsage.allocatedBytes);
+        check(resource.liveBytes() > 0, "the chart allocates from its resource");
+        check(resourceUsage.usedBytes <= resource.liveBytes(), "usedBytes does not exceed the bytes allocated");
+        check(resource.liveBytes() <= resourceUsage.allocatedBytes, "allocatedBytes covers the bytes allocated");
+        check(resourceUsage.allocatedBytes <= resource.liveBytes() + resource.liveBlockCount() * MAX_MALLOC_OVERHEAD, "allocatedBytes adds at most the malloc overhead to each block");
+
+        // Diagnostics are counted like the other components
+        check(usage.diagnostics.elementCount >= chart.diagnostics().size(), "diagnostics are counted");
+    }
+    check(resource.liveBytes() == 0, "the chart frees everything it allocated from its resource");
+
+    // The header only, before the body is loaded
+    {
+        const ksh::PlayableChart chart(argv[1], ksh::BodyLoadPolicy::OnDemand, &resource);
+        const ksh::ChartMemoryUsage usage = chart.memoryUsage();
+        check(!usage.bodyLoaded, "memoryUsage() does not load the body");
+        check(usage.metaData.usedBytes <= resource.liveBytes() && resource.liveBytes() <= usage.metaData.allocatedBytes, "header bytes are counted");
+    }
+
+    std::printf("%zu failures\n", s_failureCount);
+    return (s_failureCount == 0) ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+// PlaybackScheduler::seek() into and out of a long FX note
+// (the state at the seek position is queued without allocation)
+//
+// Usage: playback_scheduler_test <chart.ksh>
+// (the chart needs an FX note with an audio effect; tests/data/basic.ksh)
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <atomic>
+
+#include "ksh/playable_chart.hpp"
+#include "ksh/playback_scheduler.hpp"
+
+namespace
+{
+    std::atomic<std::size_t> s_allocationCount(0);
+
+    std::size_t s_failureCount = 0;
+
+    void check(bool condition, const char * description)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", description);
+            ++s_failureCount;
+        }
+    }
+
+    // Events popped right after seek(ms) (before the next pump())
+    std::vector<ksh::PlaybackEvent> seekAndPop(ksh::PlaybackScheduler & scheduler, Ms ms)
+    {
+        const std::size_t allocationCount = s_allocationCount.load();
+        scheduler.seek(ms);
+        check(s_allocationCount.load() == allocationCount, "seek() does not allocate");
+
+        std::vector<ksh::PlaybackEvent> events;
+        ksh::PlaybackEvent event;
+        while (scheduler.popUntil(ms + 1.0, event))
+        {
+            events.push_back(event);
+        }
+        return events;
+    }
+
+    const ksh::PlaybackEvent * findEvent(const std::vector<ksh::PlaybackEvent> & events, ksh::PlaybackEventType type, uint8_t lane = 0)
+    {
+        for (const auto & event : events)
+        {
+            if (event.type == type && event.lane == lane)
+            {
+                return &event;
+            }
+        }
+        return nullptr;
+    }
+}
+
+void * operator new(std::size_t size)
+{
+    ++s_allocationCount;
+    if (void * p = std::malloc((size == 0) ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    ++s_allocationCount;
+    return std::malloc((size == 0) ? 1 : size);
+}
+
+void operator delete(void * p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <chart.ksh>\n", argv[0]);
+        return 2;
+    }
+
+    const ksh::PlayableChart chart(argv[1]);
+
+    // Longest audio effect interval
+    std::size_t laneIdx = 0;
+    const ksh::AudioEffectTimeline::Interval * longest = nullptr;
+    for (std::size_t i = 0; i < ksh::DefaultLaneLayout::FX_LANE_COUNT; ++i)
+    {
+        for (const auto & interval : chart.audioEffectTimeline(i).intervals())
+        {
+            if (longest == nullptr || interval.endMs - interval.startMs > longest->endMs - longest->startMs)
+            {
+                laneIdx = i;
+                longest = &interval;
+            }
+        }
+    }
+    if (longest == nullptr)
+    {
+        std::fprintf(stderr, "No FX note with an audio effect in %s\n", argv[1]);
+        return 1;
+    }
+    const uint8_t lane = static_cast<uint8_t>(laneIdx);
+    const Ms insideMs = (longest->startMs + longest->endMs) / 2;
+    const Ms outsideMs = longest->endMs + 1.0;
+
+    ksh::PlaybackScheduler scheduler(chart);
+
+    // Play until the middle of the note (events in the look-ahead stay queued)
+    for (Ms ms = 0.0; ms < insideMs; ms += 10.0)
+    {
+        scheduler.pump(ms);
+    }
+    ksh::PlaybackEvent event;
+    while (scheduler.popUntil(insideMs, event))
+    {
+    }
+
+    // Into the note
+    {
+        const std::vector<ksh::PlaybackEvent> events = seekAndPop(scheduler, insideMs);
+        const ksh::PlaybackEvent * start = findEvent(events, ksh::PlaybackEventType::AudioEffectStart, lane);
+        check(start != nullptr && start->param == longest->effectIdx, "seeking into the note starts its audio effect");
+        check(findEvent(events, ksh::PlaybackEventType::AudioEffectEnd, lane) == nullptr, "seeking into the note does not end its audio effect");
+
+        const ksh::PlaybackEvent * tempo = findEvent(events, ksh::PlaybackEventType::TempoChange);
+        const BeatMap & beatMap = chart.beatMap();
+        check(tempo != nullptr && tempo->value == beatMap.tempo(beatMap.msToMeasure(insideMs)), "seeking restores the tempo");
+        check(findEvent(events, ksh::PlaybackEventType::FilterTypeChange) != nullptr, "seeking restores the filter type");
+        check(findEvent(events, ksh::PlaybackEventType::FilterGainChange) != nullptr, "seeking restores the filter gain");
+
+        bool allAtSeekMs = true;
+        for (const auto & e : events)
+        {
+            allAtSeekMs = allAtSeekMs && e.ms == insideMs;
+        }
+        check(allAtSeekMs, "events queued before seek() are dropped");
+    }
+
+    // Out of the note
+    {
+        const std::vector<ksh::PlaybackEvent> events = seekAndPop(scheduler, outsideMs);
+        check(findEvent(events, ksh::PlaybackEventType::AudioEffectEnd, lane) != nullptr, "seeking out of the note ends its audio effect");
+        check(findEvent(events, ksh::PlaybackEventType::AudioEffectStart, lane) == nullptr, "seeking out of the note does not start its audio effect");
+    }
+
+    // Back into the note, then play on until the note ends
+    {
+        const std::vector<ksh::PlaybackEvent> events = seekAndPop(scheduler, insideMs);
+        check(findEvent(events, ksh::PlaybackEventType::AudioEffectStart, lane) != nullptr, "seeking back into the note starts its audio effect");
+
+        bool ended = false;
+        for (Ms ms = insideMs; ms <= outsideMs + 10.0; ms += 10.0)
+        {
+            scheduler.pump(ms);
+            while (scheduler.popUntil(ms, event))
+            {
+                check(event.type != ksh::PlaybackEventType::AudioEffectStart || event.lane != lane, "the audio effect is not started twice");
+                ended = ended || (event.type == ksh::PlaybackEventType::AudioEffectEnd && event.lane == lane);
+            }
+        }
+        check(ended, "the audio effect ends at the end of the note");
+    }
+
+    std::printf("%zu failures\n", s_failureCount);
+    return (s_failureCount == 0) ? 0 : 1;
+}
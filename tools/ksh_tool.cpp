@@ -0,0 +1,413 @@
+// ksh-tool: command-line tool for inspecting, validating, normalizing and benchmarking .ksh files
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <exception>
+#include <cstdlib>
+#include <cstdint>
+
+#include "ksh/playable_chart.hpp"
+#include "ksh/chart_validator.hpp"
+#include "ksh/chart_json.hpp"
+#include "ksh/encoding/shift_jis.hpp"
+
+namespace
+{
+
+    int printUsage()
+    {
+        std::cerr
+            << "Usage: ksh-tool <command> [options]\n"
+            << "\n"
+            << "Commands:\n"
+            << "  info <chart.ksh>                      Print header and derived stats\n"
+            << "  validate [-j N] <path>...             Validate charts (directories are searched recursively)\n"
+            << "  normalize <chart.ksh> [output.ksh]    Re-export as UTF-8 with BOM, CRLF and canonical header order\n"
+            << "  json <chart.ksh> [output.json]        Export as KSON-like JSON\n"
+            << "  bench [-j N] [-n repeat] <path>...    Measure parse throughput\n"
+            << "\n"
+            << "-j N: number of threads (default: all cores)\n";
+        return 2;
+    }
+
+    // Expand directories into the .ksh files under them (recursive, sorted)
+    std::vector<std::string> collectChartFilenames(const std::vector<std::string> & paths)
+    {
+        std::vector<std::string> chartFilenames;
+        for (const auto & path : paths)
+        {
+            std::error_code ec;
+            if (!std::filesystem::is_directory(path, ec))
+            {
+                chartFilenames.push_back(path);
+                continue;
+            }
+
+            std::vector<std::string> filenames;
+            for (auto itr = std::filesystem::recursive_directory_iterator(path, ec); !ec && itr != std::filesystem::recursive_directory_iterator(); itr.increment(ec))
+            {
+                if (itr->path().extension() == ".ksh" && itr->is_regular_file(ec))
+                {
+                    filenames.push_back(itr->path().string());
+                }
+            }
+            std::sort(filenames.begin(), filenames.end());
+            chartFilenames.insert(chartFilenames.end(), filenames.begin(), filenames.end());
+        }
+        return chartFilenames;
+    }
+
+    // Parse "-j N" and "-n N" options (other arguments are returned as paths)
+    bool parseOptions(const std::vector<std::string> & args, std::size_t & threadCount, std::size_t & repeatCount, std::vector<std::string> & paths)
+    {
+        for (std::size_t i = 0; i < args.size(); ++i)
+        {
+            if (args[i] == "-j" || args[i] == "-n")
+            {
+                if (i + 1 >= args.size())
+                {
+                    return false;
+                }
+                char * end;
+                const unsigned long value = std::strtoul(args[i + 1].c_str(), &end, 10);
+                if (*end != '\0')
+                {
+                    return false;
+                }
+                (args[i] == "-j" ? threadCount : repeatCount) = static_cast<std::size_t>(value);
+                ++i;
+            }
+            else
+            {
+                paths.push_back(args[i]);
+            }
+        }
+        return !paths.empty();
+    }
+
+    const char * severityName(ksh::DiagnosticSeverity severity)
+    {
+        return (severity == ksh::DiagnosticSeverity::Error) ? "error" : "warning";
+    }
+
+    template <class Lanes>
+    std::size_t noteCount(const Lanes & lanes)
+    {
+        std::size_t count = 0;
+        for (const auto & lane : lanes)
+        {
+            count += lane.size();
+        }
+        return count;
+    }
+
+    template <class Lanes>
+    Measure endMeasure(const Lanes & lanes)
+    {
+        Measure end = 0;
+        for (const auto & lane : lanes)
+        {
+            for (const auto & [ y, note ] : lane)
+            {
+                end = std::max(end, y + note.length);
+            }
+        }
+        return end;
+    }
+
+    int runInfo(const std::vector<std::string> & args)
+    {
+        if (args.size() != 1)
+        {
+            return printUsage();
+        }
+
+        const ksh::PlayableChart chart(args[0]);
+
+        std::cout << chart.toString();
+        std::cout << "--\n";
+
+        const auto & tempoChanges = chart.beatMap().tempoChanges();
+        const auto [ minItr, maxItr ] = std::minmax_element(tempoChanges.begin(), tempoChanges.end(),
+            [](const auto & a, const auto & b) { return a.second < b.second; });
+        const Measure end = std::max({ endMeasure(chart.btLanes()), endMeasure(chart.fxLanes()), endMeasure(chart.laserLanes()) });
+        const ksh::ChartMemoryUsage memoryUsage = chart.memoryUsage();
+
+        std::cout
+            << "encoding: " << (chart.isUTF8() ? "UTF-8" : "Shift_JIS") << "\n"
+            << "version: " << chart.kshVersionInt() << "\n"
+            << "difficulty index: " << chart.difficultyIdx() << "\n"
+            << "combo: " << chart.comboCount() << "\n"
+            << "BT notes: " << noteCount(chart.btLanes()) << "\n"
+            << "FX notes: " << noteCount(chart.fxLanes()) << "\n"
+            << "laser notes: " << noteCount(chart.laserLanes()) << "\n"
+            << "tempo: " << minItr->second << "-" << maxItr->second << " (" << tempoChanges.size() << " changes)\n"
+            << "time signature changes: " << chart.beatMap().timeSigChanges().size() << "\n"
+            << "audio effects: " << chart.audioEffects().size() - 1 << "\n"
+            << "duration: " << chart.beatMap().measureToMs(end) / 1000 << " s\n"
+            << "memory: " << memoryUsage.total().allocatedBytes << " bytes\n"
+            << "diagnostics: " << chart.diagnostics().size() << "\n";
+
+        return 0;
+    }
+
+    int runValidate(const std::vector<std::string> & args)
+    {
+        std::size_t threadCount = 0;
+        std::size_t repeatCount = 1;
+        std::vector<std::string> paths;
+        if (!parseOptions(args, threadCount, repeatCount, paths))
+        {
+            return printUsage();
+        }
+
+        const ksh::CorpusValidationResult result = ksh::validateCorpus(collectChartFilenames(paths), threadCount);
+        std::size_t warningCount = 0;
+        std::size_t errorCount = 0;
+        for (const auto & report : result.reports)
+        {
+            for (const auto & diagnostic : report.diagnostics)
+            {
+                std::cout << report.filename << ":" << diagnostic.line << ": " << severityName(diagnostic.severity) << ": " << diagnostic.message << "\n";
+            }
+            warningCount += report.count(ksh::DiagnosticSeverity::Warning);
+            errorCount += report.count(ksh::DiagnosticSeverity::Error);
+        }
+
+        std::cerr
+            << result.reports.size() << " files (" << result.errorFileCount << " with errors), "
+            << errorCount << " errors, " << warningCount << " warnings\n"
+            << result.elapsedSec << " s, " << result.filesPerSec() << " files/s, " << result.megabytesPerSec() << " MB/s\n";
+
+        return (result.errorFileCount > 0) ? 1 : 0;
+    }
+
+    int runNormalize(const std::vector<std::string> & args)
+    {
+        if (args.empty() || args.size() > 2)
+        {
+            return printUsage();
+        }
+
+        const ksh::Chart chart(args[0]);
+        for (const auto & diagnostic : chart.diagnostics())
+        {
+            if (diagnostic.severity == ksh::DiagnosticSeverity::Error)
+            {
+                std::cerr << args[0] << ":" << diagnostic.line << ": error: " << diagnostic.message << "\n";
+                return 1;
+            }
+        }
+
+        std::ifstream ifs(args[0], std::ios_base::in | std::ios_base::binary);
+        std::ostringstream content;
+        content << ifs.rdbuf();
+        std::string source = content.str();
+        if (source.substr(0, 3) == "\xEF\xBB\xBF")
+        {
+            source.erase(0, 3);
+        }
+        else if (!ksh::isASCII(source))
+        {
+            source = ksh::shiftJISToUTF8(source);
+        }
+
+        // The header is replaced with Chart::toString(), and the body is copied with CRLF line endings
+        std::string output = "\xEF\xBB\xBF" + chart.toString();
+        bool inBody = false;
+        std::size_t pos = 0;
+        while (pos < source.size())
+        {
+            std::size_t lineEnd = source.find('\n', pos);
+            if (lineEnd == std::string::npos)
+            {
+                lineEnd = source.size();
+            }
+            std::string_view line(source.data() + pos, lineEnd - pos);
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.remove_suffix(1);
+            }
+            pos = lineEnd + 1;
+
+            if (!inBody)
+            {
+                inBody = (line == "--");
+                if (!inBody)
+                {
+                    continue;
+                }
+            }
+            output.append(line);
+            output.append("\r\n");
+        }
+
+        if (args.size() == 2)
+        {
+            std::ofstream ofs(args[1], std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+            if (!ofs.write(output.data(), static_cast<std::streamsize>(output.size())))
+            {
+                std::cerr << "Failed to write " << args[1] << "\n";
+                return 1;
+            }
+        }
+        else
+        {
+            std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+        }
+        return 0;
+    }
+
+    int runJSON(const std::vector<std::string> & args)
+    {
+        if (args.empty() || args.size() > 2)
+        {
+            return printUsage();
+        }
+
+        const ksh::PlayableChart chart(args[0]);
+        if (args.size() == 2)
+        {
+            std::ofstream ofs(args[1], std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+            ksh::writeChartJSON(ofs, chart);
+            if (!ofs.flush())
+            {
+                std::cerr << "Failed to write " << args[1] << "\n";
+                return 1;
+            }
+        }
+        else
+        {
+            ksh::writeChartJSON(std::cout, chart);
+            std::cout << "\n";
+        }
+        return 0;
+    }
+
+    int runBench(const std::vector<std::string> & args)
+    {
+        std::size_t threadCount = 0;
+        std::size_t repeatCount = 5;
+        std::vector<std::string> paths;
+        if (!parseOptions(args, threadCount, repeatCount, paths) || repeatCount == 0)
+        {
+            return printUsage();
+        }
+
+        const std::vector<std::string> chartFilenames = collectChartFilenames(paths);
+        uint64_t totalBytes = 0;
+        for (const auto & filename : chartFilenames)
+        {
+            std::error_code ec;
+            const auto fileSize = std::filesystem::file_size(filename, ec);
+            totalBytes += ec ? 0 : static_cast<uint64_t>(fileSize);
+        }
+
+        if (threadCount == 0)
+        {
+            threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        threadCount = std::max<std::size_t>(std::min(threadCount, chartFilenames.size()), 1);
+
+        std::cerr << chartFilenames.size() << " files, " << totalBytes << " bytes, " << threadCount << " threads\n";
+
+        std::vector<double> elapsedSecs;
+        std::atomic<std::size_t> failedCount(0);
+        for (std::size_t repeatIdx = 0; repeatIdx < repeatCount; ++repeatIdx)
+        {
+            const auto startTime = std::chrono::steady_clock::now();
+
+            std::atomic<std::size_t> nextIdx(0);
+            const auto worker = [&]()
+            {
+                for (std::size_t i = nextIdx++; i < chartFilenames.size(); i = nextIdx++)
+                {
+                    try
+                    {
+                        const ksh::PlayableChart chart(chartFilenames[i]);
+                    }
+                    catch (const std::exception &)
+                    {
+                        ++failedCount;
+                    }
+                }
+            };
+            std::vector<std::thread> threads;
+            for (std::size_t i = 1; i < threadCount; ++i)
+            {
+                threads.emplace_back(worker);
+            }
+            worker();
+            for (auto && thread : threads)
+            {
+                thread.join();
+            }
+
+            elapsedSecs.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+            std::cerr << "run " << repeatIdx + 1 << ": " << elapsedSecs.back() << " s\n";
+        }
+
+        std::sort(elapsedSecs.begin(), elapsedSecs.end());
+        const double medianSec = elapsedSecs[elapsedSecs.size() / 2];
+        std::cout
+            << "min " << elapsedSecs.front() << " s, median " << medianSec << " s\n"
+            << chartFilenames.size() / medianSec << " files/s, " << totalBytes / medianSec / (1024 * 1024) << " MB/s\n";
+        if (failedCount > 0)
+        {
+            std::cerr << failedCount / repeatCount << " files failed to parse\n";
+        }
+
+        return 0;
+    }
+
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc < 2)
+    {
+        return printUsage();
+    }
+
+    const std::string_view command = argv[1];
+    const std::vector<std::string> args(argv + 2, argv + argc);
+    try
+    {
+        if (command == "info")
+        {
+            return runInfo(args);
+        }
+        else if (command == "validate")
+        {
+            return runValidate(args);
+        }
+        else if (command == "normalize")
+        {
+            return runNormalize(args);
+        }
+        else if (command == "json")
+        {
+            return runJSON(args);
+        }
+        else if (command == "bench")
+        {
+            return runBench(args);
+        }
+    }
+    catch (const std::exception & e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return printUsage();
+}